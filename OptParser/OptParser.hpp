@@ -24,14 +24,50 @@
 #define OPT_PARSER_NS optp
 #endif
 
+#if !defined(OPT_PARSER_NO_POSIX) && (defined(__unix__) || defined(__APPLE__))
+#define OPT_PARSER_POSIX
+#endif
+
+// parse statistics updates, compiled out unless OPT_PARSER_STATS is defined; the
+// inline parse functions differ with the macro, so it must be set for the whole
+// program (e.g. with target_compile_definitions), never for some units only
+#ifdef OPT_PARSER_STATS
+#define OPT_PARSER_STAT(x) x
+#else
+#define OPT_PARSER_STAT(x)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <iomanip>
 #include <iostream>
-#include <queue>
-#include <regex>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#ifdef OPT_PARSER_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace OPT_PARSER_NS
 {
 // String utilities ////////////////////////////////////////////////////////////
@@ -73,358 +109,4862 @@ inline std::string strTo<std::string>(const std::string &str)
   return str;
 }
 
+// checked conversion, false if the string is not entirely a valid T; unsigned
+// types are read with strtoull and range-checked, since both strtoull and
+// istringstream wrap negative values around, which are rejected here
 template <typename T>
-inline std::string strFrom(const T x)
+inline bool tryStrTo(const std::string &str, T &x, std::false_type)
 {
-  std::ostringstream stream;
+  std::istringstream stream(str);
 
-  stream << x;
+  stream >> x;
 
-  return stream.str();
+  return !stream.fail() and (stream >> std::ws).eof();
 }
-
-/******************************************************************************
- *                             main class                                     *
- ******************************************************************************/
-class OptParser
+template <typename T>
+inline bool tryStrTo(const std::string &str, T &x, std::true_type)
 {
-public:
-  enum class OptType
-  {
-    value,
-    trigger
-  };
+  char *end;
+  std::size_t sign = str.find_first_not_of(" \t\n\v\f\r");
+  unsigned long long l;
 
-private:
-  struct OptPar
-  {
-    std::string shortName, longName, defaultVal, helpMessage;
-    OptType type;
-    bool optional;
-  };
-  struct OptRes
-  {
-    std::string value;
-    bool present;
-  };
+  errno = 0;
+  l = strtoull(str.c_str(), &end, 10);
+  x = static_cast<T>(l);
 
-public:
-  // constructor
-  OptParser(void) = default;
-  // destructor
-  virtual ~OptParser(void) = default;
-  // access
-  void addOption(const std::string shortName, const std::string longName,
-                 const OptType type, const bool optional = false,
-                 const std::string helpMessage = "", const std::string defaultVal = "");
-  bool gotOption(const std::string name) const;
-  template <typename T = std::string>
-  T optionValue(const std::string name) const;
-  const std::vector<std::string> &getArgs(void) const;
-  // parse
-  bool parse(const int argc, const char *argv[]);
-  // print option list
-  friend std::ostream &operator<<(std::ostream &out, const OptParser &parser);
+  return (end != str.c_str()) and (end == str.c_str() + str.size()) and
+         (errno == 0) and (str[sign] != '-') and (l <= std::numeric_limits<T>::max());
+}
+template <typename T>
+inline bool tryStrTo(const std::string &str, T &x)
+{
+  return tryStrTo(str, x, typename std::is_unsigned<T>::type());
+}
 
-private:
-  // find option index
-  int optIndex(const std::string name) const;
-  // option name for messages
-  static std::string optName(const OptPar &opt);
+// optimized specializations
+template <>
+inline bool tryStrTo<float>(const std::string &str, float &x)
+{
+  char *end;
 
-private:
-  std::vector<OptPar> opt_;
-  std::vector<OptRes> result_;
-  std::vector<std::string> arg_;
-  static const std::regex optRegex_;
-};
+  errno = 0;
+  x = strtof(str.c_str(), &end);
 
-/******************************************************************************
- *                         OptParser implementation                           *
- ******************************************************************************/
-// regular expression //////////////////////////////////////////////////////////
-constexpr char optRegex[] = "(-([a-zA-Z])(.+)?)|(--([a-zA-Z_-]+)=?(.+)?)";
+  return (end != str.c_str()) and (end == str.c_str() + str.size()) and (errno == 0);
+}
+template <>
+inline bool tryStrTo<double>(const std::string &str, double &x)
+{
+  char *end;
 
-const std::regex OptParser::optRegex_(optRegex);
+  errno = 0;
+  x = strtod(str.c_str(), &end);
 
-// access //////////////////////////////////////////////////////////////////////
-void OptParser::addOption(const std::string shortName, const std::string longName,
-                          const OptType type, const bool optional,
-                          const std::string helpMessage, const std::string defaultVal)
-{
-  OptPar par;
-
-  par.shortName = shortName;
-  par.longName = longName;
-  par.defaultVal = defaultVal;
-  par.helpMessage = helpMessage;
-  par.type = type;
-  par.optional = optional;
-  auto it =
-      std::find_if(opt_.begin(), opt_.end(),
-                   [&par](const OptPar &p)
-                   {
-                     bool match = false;
-
-                     match |= (par.shortName == p.shortName) and !par.shortName.empty();
-                     match |= (par.longName == p.longName) and !par.longName.empty();
-
-                     return match;
-                   });
-  if (it != opt_.end())
-  {
-    std::string opt;
+  return (end != str.c_str()) and (end == str.c_str() + str.size()) and (errno == 0);
+}
+template <>
+inline bool tryStrTo<long>(const std::string &str, long &x)
+{
+  char *end;
 
-    if (!it->shortName.empty())
-    {
-      opt += "-" + it->shortName;
-    }
-    if (!opt.empty())
-    {
-      opt += "/";
-    }
-    if (!it->longName.empty())
-    {
-      opt += "--" + it->longName;
-    }
-    throw(std::logic_error("duplicate option " + opt));
-  }
-  opt_.push_back(par);
+  errno = 0;
+  x = strtol(str.c_str(), &end, 10);
+
+  return (end != str.c_str()) and (end == str.c_str() + str.size()) and (errno == 0);
 }
+template <>
+inline bool tryStrTo<int>(const std::string &str, int &x)
+{
+  long l;
+  bool ok = tryStrTo<long>(str, l) and (l >= INT_MIN) and (l <= INT_MAX);
+
+  x = static_cast<int>(l);
 
-bool OptParser::gotOption(const std::string name) const
+  return ok;
+}
+template <>
+inline bool tryStrTo<std::string>(const std::string &str, std::string &x)
 {
-  int i = optIndex(name);
+  x = str;
 
-  if (result_.size() != opt_.size())
-  {
-    throw(std::runtime_error("options not parsed"));
-  }
-  if (i >= 0)
+  return true;
+}
+
+// name of T in conversion error messages
+template <typename T>
+inline std::string typeName(void)
+{
+  if (std::is_integral<T>::value)
   {
-    return result_[i].present;
+    return std::is_signed<T>::value ? "integer" : "unsigned integer";
   }
-  else
+  else if (std::is_floating_point<T>::value)
   {
-    throw(std::out_of_range("no option with name '" + name + "'"));
+    return "number";
   }
+
+  return "value";
 }
 
 template <typename T>
-T OptParser::optionValue(const std::string name) const
+inline std::string strFrom(const T x)
 {
-  int i = optIndex(name);
+  std::ostringstream stream;
+
+  stream << x;
+
+  return stream.str();
+}
 
-  if (result_.size() != opt_.size())
+// 128-bit non-cryptographic hash (MurmurHash3 x64_128)
+struct Hash128
+{
+  uint64_t low, high;
+  std::string hex(void) const;
+  bool operator==(const Hash128 &h) const;
+  bool operator!=(const Hash128 &h) const;
+};
+
+inline Hash128 hash128(const char *data, const std::size_t size, const uint64_t seed = 0)
+{
+  const uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+  const std::size_t nBlock = size / 16;
+  const unsigned char *tail = reinterpret_cast<const unsigned char *>(data) + 16 * nBlock;
+  uint64_t h1 = seed, h2 = seed, k1 = 0, k2 = 0;
+  auto rotl = [](const uint64_t x, const int r) { return (x << r) | (x >> (64 - r)); };
+  auto fmix = [](uint64_t k)
   {
-    throw(std::runtime_error("options not parsed"));
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+
+    return k;
+  };
+
+  for (std::size_t i = 0; i < nBlock; ++i)
+  {
+    std::memcpy(&k1, data + 16 * i, 8);
+    std::memcpy(&k2, data + 16 * i + 8, 8);
+    k1 *= c1;
+    k1 = rotl(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = rotl(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+    k2 *= c2;
+    k2 = rotl(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = rotl(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
   }
-  if (i >= 0)
+  k1 = 0;
+  k2 = 0;
+  for (std::size_t i = size % 16; i > 8; --i)
   {
-    return strTo<T>(result_[i].value);
+    k2 ^= uint64_t(tail[i - 1]) << (8 * (i - 9));
   }
-  else
+  if (size % 16 > 8)
   {
-    throw(std::out_of_range("no option with name '" + name + "'"));
+    k2 *= c2;
+    k2 = rotl(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
   }
-}
+  for (std::size_t i = std::min<std::size_t>(size % 16, 8); i > 0; --i)
+  {
+    k1 ^= uint64_t(tail[i - 1]) << (8 * (i - 1));
+  }
+  if (size % 16 > 0)
+  {
+    k1 *= c1;
+    k1 = rotl(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix(h1);
+  h2 = fmix(h2);
+  h1 += h2;
+  h2 += h1;
 
-const std::vector<std::string> &OptParser::getArgs(void) const { return arg_; }
+  return {h1, h2};
+}
 
-// parse ///////////////////////////////////////////////////////////////////////
-bool OptParser::parse(const int argc, const char *argv[])
+inline std::string Hash128::hex(void) const
 {
-  std::smatch sm;
-  std::queue<std::string> arg;
-  int expectVal = -1;
-  bool isCorrect = true;
+  char buf[33];
 
-  for (int i = 1; i < argc; ++i)
-  {
-    arg.push(argv[i]);
-  }
-  result_.clear();
-  result_.resize(opt_.size());
-  arg_.clear();
-  for (unsigned int i = 0; i < opt_.size(); ++i)
+  // bytes of low then high in little-endian order, as printed by the reference
+  // implementation and tools such as mmh3
+  for (unsigned int i = 0; i < 16; ++i)
   {
-    result_[i].value = opt_[i].defaultVal;
+    uint64_t w = (i < 8) ? low : high;
+    unsigned int byte = static_cast<unsigned int>((w >> (8 * (i % 8))) & 0xff);
+
+    std::snprintf(buf + 2 * i, 3, "%02x", byte);
   }
-  while (!arg.empty())
+
+  return buf;
+}
+
+inline bool Hash128::operator==(const Hash128 &h) const
+{
+  return (low == h.low) and (high == h.high);
+}
+
+inline bool Hash128::operator!=(const Hash128 &h) const { return !(*this == h); }
+
+// shell-style wildcard match: '*' any sequence, '?' any character, '[a-z]' or
+// '[!a-z]' character sets
+inline bool globMatch(const std::string &str, const std::string &pattern)
+{
+  std::size_t s = 0, p = 0, starP = std::string::npos, starS = 0;
+
+  while (s < str.size())
   {
-    // option
-    if (regex_match(arg.front(), sm, optRegex_))
+    bool match = false;
+    std::size_t next = p + 1;
+
+    if ((p < pattern.size()) and (pattern[p] == '*'))
+    {
+      starP = p++;
+      starS = s;
+      continue;
+    }
+    if (p < pattern.size())
     {
-      // should it be a value?
-      if (expectVal >= 0)
+      if (pattern[p] == '?')
       {
-        std::cerr << "warning: expected value for option ";
-        std::cerr << optName(opt_[expectVal]);
-        std::cerr << ", got option '" << arg.front() << "' instead" << std::endl;
-        expectVal = -1;
-        isCorrect = false;
+        match = true;
       }
-      // short option
-      if (sm[1].matched)
+      else if ((pattern[p] == '[') and (pattern.find(']', p + 2) != std::string::npos))
       {
-        std::string optName = sm[2].str();
-
-        // find option
-        auto it =
-            find_if(opt_.begin(), opt_.end(),
-                    [&optName](const OptPar &p) { return (p.shortName == optName); });
+        std::size_t end = pattern.find(']', p + 2), q = p + 1;
+        bool negate = (pattern[q] == '!');
 
-        // parse if found
-        if (it != opt_.end())
+        q += negate ? 1 : 0;
+        for (; q < end; ++q)
         {
-          unsigned int i = it - opt_.begin();
-
-          result_[i].present = true;
-          if (opt_[i].type == OptType::value)
+          if ((q + 2 < end) and (pattern[q + 1] == '-'))
           {
-            if (sm[3].matched)
-            {
-              result_[i].value = sm[3].str();
-            }
-            else
-            {
-              expectVal = i;
-            }
+            match |= (str[s] >= pattern[q]) and (str[s] <= pattern[q + 2]);
+            q += 2;
           }
-        }
-        // warning if not found
-        else
-        {
-          std::cerr << "warning: unknown option '" << arg.front() << "'";
-          std::cerr << std::endl;
-        }
-      }
-      // long option
-      else if (sm[4].matched)
-      {
-        std::string optName = sm[5].str();
-
-        // find option
-        auto it =
-            find_if(opt_.begin(), opt_.end(),
-                    [&optName](const OptPar &p) { return (p.longName == optName); });
-
-        // parse if found
-        if (it != opt_.end())
-        {
-          unsigned int i = it - opt_.begin();
-
-          result_[i].present = true;
-          if (opt_[i].type == OptType::value)
+          else
           {
-            if (sm[6].matched)
-            {
-              result_[i].value = sm[6].str();
-            }
-            else
-            {
-              expectVal = i;
-            }
+            match |= (str[s] == pattern[q]);
           }
         }
-        // warning if not found
-        else
-        {
-          std::cerr << "warning: unknown option '" << arg.front() << "'";
-          std::cerr << std::endl;
-        }
+        match ^= negate;
+        next = end + 1;
+      }
+      else
+      {
+        match = (pattern[p] == str[s]);
       }
     }
-    else if (expectVal >= 0)
+    if (match)
+    {
+      p = next;
+      ++s;
+    }
+    else if (starP != std::string::npos)
     {
-      result_[expectVal].value = arg.front();
-      expectVal = -1;
+      p = starP + 1;
+      s = ++starS;
     }
     else
     {
-      arg_.push_back(arg.front());
+      return false;
     }
-    arg.pop();
-  }
-  if (expectVal >= 0)
-  {
-    std::cerr << "warning: expected value for option ";
-    std::cerr << optName(opt_[expectVal]) << std::endl;
-    expectVal = -1;
-    isCorrect = false;
   }
-  for (unsigned int i = 0; i < opt_.size(); ++i)
+  while ((p < pattern.size()) and (pattern[p] == '*'))
   {
-    if (!opt_[i].optional and !result_[i].present)
-    {
-      std::cerr << "warning: mandatory option " << optName(opt_[i]);
-      std::cerr << " is missing" << std::endl;
-      isCorrect = false;
-    }
+    ++p;
   }
 
-  return isCorrect;
+  return (p == pattern.size());
 }
 
-// find option index ///////////////////////////////////////////////////////////
-int OptParser::optIndex(const std::string name) const
+// Validators //////////////////////////////////////////////////////////////////
+// check on an option value converted to T, message describes the requirement
+template <typename T>
+struct Validator
 {
-  auto it = find_if(opt_.begin(), opt_.end(),
-                    [&name](const OptPar &p)
-                    { return (p.shortName == name) or (p.longName == name); });
+  std::function<bool(const T &)> check;
+  std::string message;
+};
 
-  if (it != opt_.end())
-  {
-    return static_cast<int>(it - opt_.begin());
-  }
-  else
-  {
-    return -1;
-  }
+template <typename T>
+inline Validator<T> inRange(const T min, const T max)
+{
+  return {[min, max](const T &x) { return (x >= min) and (x <= max); },
+          "must be in [" + strFrom(min) + ", " + strFrom(max) + "]"};
 }
 
-// option name for messages ////////////////////////////////////////////////////
-std::string OptParser::optName(const OptPar &opt)
+inline Validator<std::string> matchesGlob(const std::string pattern)
 {
-  std::string res = "";
+  return {[pattern](const std::string &x) { return globMatch(x, pattern); },
+          "must match '" + pattern + "'"};
+}
+
+// bytes held by a parser or a parse result: the object itself, its heap blocks
+// by content, and an estimate of the allocator bookkeeping and rounding (a
+// size word per block and 16-byte granularity, as in common 64-bit mallocs)
+struct MemoryUsage
+{
+  std::size_t object{0}, names{0}, help{0}, defaults{0}, values{0}, positionals{0},
+      index{0}, overhead{0};
+
+  std::size_t total(void) const;
+  // count a heap block in field, a member of this structure
+  void addBlock(std::size_t &field, const std::size_t size);
+  void addString(std::size_t &field, const std::string &s);
+  void addStrings(std::size_t &field, const std::vector<std::string> &v);
+  template <typename T>
+  void addVector(std::size_t &field, const std::vector<T> &v);
+  // allocator overhead of a block
+  static std::size_t blockOverhead(const std::size_t size);
+  // false for a string held in its small buffer
+  static bool isHeap(const std::string &s);
+};
+
+// Levenshtein distance of texts to a fixed pattern, using Myers' bit-parallel
+// algorithm (one machine word per text character for patterns of up to 64
+// characters, plain dynamic programming beyond)
+class EditDistance
+{
+public:
+  explicit EditDistance(const std::string &pattern);
+  // distance to text, or any value larger than max if it exceeds max
+  unsigned int operator()(const std::string &text, const unsigned int max) const;
+  unsigned int operator()(const char *text, const std::size_t size,
+                          const unsigned int max) const;
+
+private:
+  std::string pattern_;
+  uint64_t peq_[256];
+};
+
+// perfect hash over a fixed set of strings (hash and displace): keys are spread
+// over small buckets by a first hash, and each bucket gets a seed for which all
+// its keys land in distinct free slots of the table
+class PerfectHash
+{
+public:
+  PerfectHash(void) = default;
+  explicit PerfectHash(const std::vector<std::string> &key);
+  // index of str in the key set, -1 if absent
+  int find(const std::string &str) const;
+  // seeded 64-bit string hash
+  static uint64_t hash(const std::string &str, const uint64_t seed);
+  // heap blocks, counted in field
+  void memoryUsage(MemoryUsage &usage, std::size_t &field) const;
 
-  if (!opt.shortName.empty())
+private:
+  std::vector<std::string> key_;
+  std::vector<int> slot_;
+  std::vector<uint32_t> seed_;
+  uint64_t mask_{0};
+};
+
+// fixed-size bitset with word-wide set operations
+class Bitset
+{
+public:
+  Bitset(void) = default;
+  explicit Bitset(const std::size_t size);
+  // access
+  std::size_t size(void) const;
+  bool test(const std::size_t i) const;
+  void set(const std::size_t i, const bool value = true);
+  // number of bits set
+  std::size_t count(void) const;
+  // number of bits set in both this and b
+  std::size_t countAnd(const Bitset &b) const;
+  // true if all bits set in this are also set in b
+  bool subsetOf(const Bitset &b) const;
+  // indices of the bits set
+  std::vector<unsigned int> indices(void) const;
+  // underlying words
+  const std::vector<uint64_t> &words(void) const;
+
+  // heap blocks, counted in field
+  void memoryUsage(MemoryUsage &usage, std::size_t &field) const;
+
+private:
+  static unsigned int popcount(uint64_t x);
+
+private:
+  std::vector<uint64_t> word_;
+  std::size_t size_{0};
+};
+
+/******************************************************************************
+ *                          frozen parse result                               *
+ ******************************************************************************/
+// Immutable copy of a parse result in one contiguous block that only contains
+// offsets, so that it can be copied or mapped anywhere. Layout:
+//   Header
+//   presence bitset            uint64_t[(nOpt + 63) / 64]
+//   choice index per option    int32_t[nOpt]
+//   string offsets             uint32_t[3 * nOpt + nArg + 1]
+//   string data                NUL-terminated values, short names, long names,
+//                              then positional arguments
+// All accessors are const and the block is never modified after creation,
+// so a FrozenResult can be read concurrently from any number of threads.
+// The block is also the binary serialisation of the result; it uses the byte
+// order of the host and a blob from a different architecture is rejected by
+// the magic number check.
+class FrozenResult
+{
+public:
+  struct Header
   {
-    res += "-" + opt.shortName;
-    if (!opt.longName.empty())
-    {
-      res += "/";
-    }
-  }
-  if (!opt.longName.empty())
+    uint32_t magic, version;
+    uint64_t size, schema;
+    uint32_t nOpt, nArg;
+    uint32_t presence, choice, offset, data;
+  };
+  // class constants are never bound to references, so that they need no
+  // out-of-class definition (which would be duplicated in every translation unit)
+  static constexpr uint32_t magic = 0x5254504f; // "OPTR"
+  static constexpr uint32_t version = 1;
+
+public:
+  // constructor
+  FrozenResult(void) = default;
+  // access by index, std::out_of_range if the index is out of range
+  unsigned int optionCount(void) const;
+  bool gotOption(const unsigned int i) const;
+  const char *optionValue(const unsigned int i) const;
+  std::size_t optionSize(const unsigned int i) const;
+  int optionChoice(const unsigned int i) const;
+  unsigned int argCount(void) const;
+  const char *arg(const unsigned int i) const;
+  std::size_t argSize(const unsigned int i) const;
+  // access by name
+  int optIndex(const std::string &name) const;
+  bool gotOption(const std::string name) const;
+  template <typename T = std::string>
+  T optionValue(const std::string name) const;
+  template <typename E = int>
+  E optionChoice(const std::string name) const;
+  std::vector<std::string> getArgs(void) const;
+  // raw block
+  bool empty(void) const;
+  const char *data(void) const;
+  std::size_t size(void) const;
+  uint64_t schema(void) const;
+  // bytes of the block by content
+  MemoryUsage memoryUsage(void) const;
+  // binary serialisation
+  std::string serialize(void) const;
+  static FrozenResult deserialize(const void *data, const std::size_t size);
+  static FrozenResult deserialize(const std::string &blob);
+#ifdef OPT_PARSER_POSIX
+  // named POSIX shared-memory segment holding the block, attached results
+  // read the mapping directly; attach waits up to attachTimeout for a segment
+  // being (re)published
+  static constexpr unsigned int attachTimeout = 100; // ms
+  void publish(const std::string &name) const;
+  static FrozenResult attach(const std::string &name);
+  static void unpublish(const std::string &name);
+#endif
+  // snapshot file: SnapshotHeader followed by the block
+  void writeSnapshot(const std::string &path) const;
+  static FrozenResult readSnapshot(const std::string &path);
+
+private:
+  struct SnapshotHeader
   {
-    res += "--" + opt.longName;
-    if (opt.type == OptParser::OptType::value)
-    {
-      res += "=";
-    }
-  }
+    uint32_t magic, version;
+    uint64_t checksum, size, reserved;
+  };
+  static constexpr uint32_t snapshotMagic = 0x5354504f; // "OPTS"
+  static constexpr uint32_t snapshotVersion = 1;
 
-  return res;
-}
+private:
+  static void validate(const char *data, const std::size_t size);
+  static uint64_t checksum(const char *data, const std::size_t size);
+  const Header &header(void) const;
+  const uint32_t *offset(void) const;
+  const char *str(const unsigned int i) const;
+  std::size_t strSize(const unsigned int i) const;
+  unsigned int checkedIndex(const std::string &name) const;
+  void checkOption(const unsigned int i) const;
+  void checkArg(const unsigned int i) const;
 
-// print option list ///////////////////////////////////////////////////////////
-std::ostream &operator<<(std::ostream &out, const OPT_PARSER_NS::OptParser &parser);
+private:
+  friend class OptParser;
+  std::shared_ptr<const void> owner_;
+  const char *data_{nullptr};
+};
+
+// handlers for event-driven parsing, called in command-line order; strings are
+// NUL-terminated views into the parsed arguments, valid during the call only
+class ParseVisitor
+{
+public:
+  virtual ~ParseVisitor(void) = default;
+  // option with index opt (position in the schema), value is null for
+  // triggers and for options missing their value
+  virtual void option(const unsigned int opt, const char *value, const std::size_t size);
+  // positional argument
+  virtual void positional(const char *arg, const std::size_t size);
+};
 
-std::ostream &operator<<(std::ostream &out, const OPT_PARSER_NS::OptParser &parser)
+// event of a pull parse, with the same meaning as the ParseVisitor arguments;
+// value points into the parsed arguments
+struct ParseEvent
 {
-  for (auto &o : parser.opt_)
+  enum class Type
   {
-    out << std::setw(20) << OPT_PARSER_NS::OptParser::optName(o);
-    out << ": " << o.helpMessage;
-    if (!o.defaultVal.empty())
-    {
-      out << " (default: " << o.defaultVal << ")";
+    option,
+    positional
+  };
+  Type type;
+  unsigned int opt;
+  const char *value;
+  std::size_t size;
+};
+
+// counters and phase timings of a parse (nanoseconds, monotonic clock), filled
+// when OPT_PARSER_STATS is defined; the scan phases of parseParallel add up the
+// time of all threads
+struct ParseStats
+{
+  uint64_t token{0}, lookup{0}, conversion{0}, unknown{0}, byteCopied{0};
+  uint64_t tokenizeTime{0}, lookupTime{0}, convertTime{0}, validateTime{0},
+      mandatoryTime{0}, parseTime{0};
+
+  ParseStats &operator+=(const ParseStats &stats);
+};
+
+// adds the time spent in a scope to a counter, in nanoseconds
+class ScopeTimer
+{
+public:
+  explicit ScopeTimer(uint64_t &ns);
+  ~ScopeTimer(void);
+
+private:
+  uint64_t &ns_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// ring buffer of the last parse decisions, attached to a parser with setTrace;
+// recording does not allocate, and dump(fd) only calls write(), so that the
+// trace can be dumped from a crash handler
+class ParseTrace
+{
+public:
+  // how the token was read
+  enum class Kind : uint8_t
+  {
+    argument,
+    shortOption,
+    longOption
+  };
+  // what was done with it
+  enum class Action : uint8_t
+  {
+    positional,   // positional argument
+    value,        // value of the option waiting for it
+    option,       // trigger, or option with its value in the token
+    expectValue,  // option waiting for its value in the next token
+    missingValue, // option whose value never came
+    unknown,      // unknown option, ignored
+    ambiguous     // ambiguous abbreviation, ignored
+  };
+  struct Entry
+  {
+    uint32_t token; // index in the arguments, without program name
+    int32_t opt;    // option index, -1 if none
+    Kind kind;
+    Action action;
+  };
+  static constexpr unsigned int capacity = 1024;
+
+public:
+  ParseTrace(void) = default;
+  ParseTrace(const ParseTrace &) = delete;
+  ParseTrace &operator=(const ParseTrace &) = delete;
+  void clear(void);
+  void record(const uint32_t token, const Kind kind, const int32_t opt,
+              const Action action);
+  // number of entries kept, and recorded since the last clear
+  std::size_t size(void) const;
+  uint64_t total(void) const;
+  // i-th kept entry, oldest first
+  const Entry &operator[](const std::size_t i) const;
+  // one line per entry, oldest first
+  void dump(std::ostream &out) const;
+#ifdef OPT_PARSER_POSIX
+  void dump(const int fd) const;
+#endif
+
+private:
+  // line for an entry in buf, returns its size
+  static std::size_t format(const Entry &e, char *buf);
+
+private:
+  static constexpr std::size_t lineSize = 64;
+  Entry entry_[capacity];
+  std::atomic<uint64_t> next_{0};
+};
+
+// argument vector with all strings in a single arena, argv() is terminated by
+// a null pointer and can be passed to exec; movable but not copyable since the
+// pointers refer to the arena
+class Argv
+{
+public:
+  Argv(void) = default;
+  Argv(const Argv &) = delete;
+  Argv(Argv &&) = default;
+  Argv &operator=(const Argv &) = delete;
+  Argv &operator=(Argv &&) = default;
+  int argc(void) const;
+  char **argv(void);
+  // command line with POSIX shell quoting
+  std::string str(void) const;
+
+private:
+  friend class OptParser;
+  std::vector<char> arena_;
+  std::vector<char *> ptr_;
+};
+
+/******************************************************************************
+ *                             main class                                     *
+ ******************************************************************************/
+class OptParser
+{
+public:
+  enum class OptType
+  {
+    value,
+    trigger
+  };
+  enum class Shell
+  {
+    bash,
+    zsh
+  };
+  // checks on path values, combined with |
+  enum PathCheck : unsigned int
+  {
+    pathExists = 1 << 0,
+    pathIsFile = 1 << 1,
+    pathIsDir = 1 << 2,
+    pathReadable = 1 << 3,
+    pathWritable = 1 << 4,
+    pathExecutable = 1 << 5,
+    // writable if it exists, or in a writable directory otherwise
+    pathCreatable = 1 << 6
+  };
+  // positional argument that is not a valid value of the requested type
+  struct ConversionError
+  {
+    std::size_t index;
+    std::string arg;
+  };
+  class StreamReader;
+  // lazy parse of a command line: events are produced on demand, by next() or by
+  // iterating over the reader, so that the parse can stop at any point; unknown
+  // options and missing values are reported as warnings, but choices,
+  // validators and constraints are not checked, and the parser must not be
+  // modified while reading
+  class EventReader
+  {
+  public:
+    class Iterator
+    {
+    public:
+      explicit Iterator(EventReader *reader = nullptr);
+      const ParseEvent &operator*(void) const;
+      const ParseEvent *operator->(void) const;
+      Iterator &operator++(void);
+      bool operator==(const Iterator &it) const;
+      bool operator!=(const Iterator &it) const;
+
+    private:
+      EventReader *reader_;
+      ParseEvent event_{};
+    };
+
+  public:
+    // next event, false at the end of the command line
+    bool next(ParseEvent &event);
+    // false if a warning was issued so far
+    bool isCorrect(void) const;
+    Iterator begin(void);
+    Iterator end(void);
+
+  private:
+    friend class OptParser;
+    friend class StreamReader;
+    EventReader(const OptParser &parser, const int n, const char *const *token);
+    bool pop(ParseEvent &event);
+    void scan(const char *arg);
+    int lookup(const char *arg, const std::size_t keySize, const bool isLong,
+               std::vector<std::string> &candidate);
+    void finish(void);
+    void note(const uint32_t token, const ParseTrace::Kind kind, const int opt,
+              const ParseTrace::Action action);
+    void push(const ParseEvent::Type type, const unsigned int opt, const char *value,
+              const std::size_t size);
+
+  private:
+    const OptParser &parser_;
+    const char *const *token_;
+    std::ostream *log_{&std::cerr};
+    int n_, t_{0}, expectVal_{-1};
+    // a token produces at most two events: a missing value and an option
+    ParseEvent pending_[2];
+    unsigned int nPending_{0}, iPending_{0};
+    bool isCorrect_{true};
+    ParseTrace *trace_;
+    uint32_t index_{0};
+    ParseStats stats_;
+  };
+  // incremental parse of a stream of NUL-terminated arguments (as written by
+  // "printf '%s\0'" or found in /proc/<pid>/cmdline) received in chunks of any
+  // size; after each feed(), next() returns the events completed by the chunk
+  // and false once it needs more input, so that several streams can be read
+  // from one thread; a token split across chunks is kept in a buffer, and
+  // events point into the chunk or this buffer until the next call to next()
+  class StreamReader
+  {
+  public:
+    // the chunk must stay valid until next() returns false
+    void feed(const char *data, const std::size_t size);
+    // end of stream, a last argument may lack its terminating NUL
+    void close(void);
+    bool next(ParseEvent &event);
+    // true once the stream is closed and all its events are read
+    bool done(void) const;
+    bool isCorrect(void) const;
+
+  private:
+    friend class OptParser;
+    explicit StreamReader(const OptParser &parser);
+
+  private:
+    EventReader reader_;
+    const char *pos_{nullptr}, *end_{nullptr};
+    std::string partial_;
+    bool carry_{false}, closed_{false}, done_{false};
+  };
+
+private:
+  // compressed prefix trie over command-line option names ("-a", "--long-a")
+  class NameTrie
+  {
+  public:
+    void clear(void);
+    void insert(const std::string &key, const unsigned int opt);
+    int find(const std::string &key) const;
+    int find(const char *key, const std::size_t size) const;
+    int findPrefix(const char *key, const std::size_t size,
+                   std::vector<std::string> &candidate) const;
+    void seal(void);
+    void complete(const std::string &prefix, std::vector<std::string> &match) const;
+    void memoryUsage(MemoryUsage &usage, std::size_t &field) const;
+
+  private:
+    struct Node
+    {
+      std::string label;
+      std::vector<unsigned int> child;
+      int opt{-1}, unique{-1};
+    };
+
+  private:
+    int child(const unsigned int n, const char c) const;
+    int walk(const char *key, const std::size_t size, bool &exact,
+             std::size_t &base) const;
+    int seal(const unsigned int n);
+    void collect(const unsigned int n, std::string &key,
+                 std::vector<std::string> &match) const;
+
+  private:
+    std::vector<Node> node_;
+  };
+  // validators of an option grouped by value type, so that the value is
+  // converted once per type
+  class CheckBase
+  {
+  public:
+    virtual ~CheckBase(void) = default;
+    virtual void run(const std::string &value, const std::string &opt,
+                     std::vector<std::string> &violation) const = 0;
+  };
+  template <typename T>
+  class Check : public CheckBase
+  {
+  public:
+    virtual void run(const std::string &value, const std::string &opt,
+                     std::vector<std::string> &violation) const;
+
+  public:
+    std::vector<Validator<T>> validator;
+  };
+  // slice of the string table
+  struct StrRef
+  {
+    uint32_t offset, size;
+  };
+  // option flags
+  enum : uint8_t
+  {
+    valueFlag = 1 << 0,
+    optionalFlag = 1 << 1,
+    noFingerprintFlag = 1 << 2,
+    numericFlag = 1 << 3
+  };
+  // data specific to choice options and options with validators
+  struct OptExtra
+  {
+    std::vector<std::string> choice;
+    PerfectHash choiceHash;
+    std::vector<std::shared_ptr<CheckBase>> check;
+    unsigned int pathCheck{0};
+  };
+  enum class Relation
+  {
+    dependency,
+    conflict,
+    exactlyOne
+  };
+  struct Constraint
+  {
+    Relation type;
+    int source;
+    std::vector<unsigned int> opt;
+    Bitset mask;
+  };
+  // option token split by lexOption, the lookup key is the token prefix
+  // "-n" or "--name" of size keySize
+  struct OptToken
+  {
+    bool isLong;
+    std::size_t keySize;
+    const char *value;
+    std::size_t valueSize;
+  };
+  // stream buffer appending to a string, whose size is the write position
+  class LogBuffer : public std::streambuf
+  {
+  public:
+    std::string log;
+
+  protected:
+    virtual int_type overflow(int_type c);
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+  };
+  // tokens [begin, end) scanned by parseParallel: events, warnings and the
+  // position in the warnings after each event
+  struct ScanChunk
+  {
+    int begin, end, expectVal;
+    bool isOption, isCorrect;
+    std::vector<ParseEvent> event;
+    std::vector<std::size_t> logEnd;
+    std::size_t firstLogEnd, skip, argOffset;
+    std::string log;
+    ParseStats stats;
+  };
+  // path value to check, with its option or argument name for messages
+  struct PathItem
+  {
+    std::string name, path;
+    unsigned int check;
+  };
+  struct OptRes
+  {
+    std::string value;
+    bool present;
+    int choice{-1};
+  };
+  // stores events in the parse result
+  class ResultVisitor : public ParseVisitor
+  {
+  public:
+    explicit ResultVisitor(OptParser &parser);
+    virtual void option(const unsigned int opt, const char *value, const std::size_t size);
+    virtual void positional(const char *arg, const std::size_t size);
+
+  public:
+    bool isCorrect{true};
+
+  private:
+    OptParser &parser_;
+  };
+  // checks events against the schema before forwarding them
+  class CheckVisitor : public ParseVisitor
+  {
+  public:
+    CheckVisitor(OptParser &parser, ParseVisitor &visitor);
+    virtual void option(const unsigned int opt, const char *value, const std::size_t size);
+    virtual void positional(const char *arg, const std::size_t size);
+
+  public:
+    bool isCorrect{true};
+    Bitset present;
+    std::vector<PathItem> path;
+    std::size_t nArg{0};
+
+  private:
+    OptParser &parser_;
+    ParseVisitor &visitor_;
+  };
+
+public:
+  // constructor
+  OptParser(void) = default;
+  // destructor
+  virtual ~OptParser(void) = default;
+  // access
+  void addOption(const std::string shortName, const std::string longName,
+                 const OptType type, const bool optional = false,
+                 const std::string helpMessage = "", const std::string defaultVal = "");
+  void addChoice(const std::string shortName, const std::string longName,
+                 const std::vector<std::string> choice, const bool optional = false,
+                 const std::string helpMessage = "", const std::string defaultVal = "");
+  // relations checked at the end of parse
+  void addDependency(const std::string name, const std::vector<std::string> required);
+  void addConflict(const std::vector<std::string> name);
+  void addExactlyOne(const std::vector<std::string> name);
+  // value checks run once by parse on present options
+  template <typename T>
+  void addValidator(const std::string name, const Validator<T> validator);
+#ifdef OPT_PARSER_POSIX
+  // path checks run concurrently by parse on present options and on all
+  // positional arguments, failures are reported with the validator violations
+  void addPathCheck(const std::string name, const unsigned int check);
+  void addArgPathCheck(const unsigned int check);
+#endif
+  bool gotOption(const std::string name) const;
+  std::vector<std::string> suggest(const std::string name) const;
+  template <typename T = std::string>
+  T optionValue(const std::string name) const;
+  template <typename E = int>
+  E optionChoice(const std::string name) const;
+  void setOption(const std::string name, const std::string value = "");
+  void unsetOption(const std::string name);
+  const std::vector<std::string> &getArgs(void) const;
+  // positional arguments converted to T, concurrently by nThread threads
+  // (0: one per core) for large inputs; invalid arguments are left
+  // value-initialised and listed in error, or thrown without it
+  template <typename T>
+  std::vector<T> getArgs(std::vector<ConversionError> &error,
+                         unsigned int nThread = 0) const;
+  template <typename T>
+  std::vector<T> getArgs(void) const;
+  const std::vector<std::string> &getViolations(void) const;
+  // accept unambiguous prefixes of long option names
+  void allowAbbreviation(const bool allow = true);
+  // parse
+  bool parse(const int argc, const char *argv[]);
+  bool parse(const std::string &cmdline);
+  // event-driven parse, the parse result is left untouched
+  bool parse(const int argc, const char *argv[], ParseVisitor &visitor);
+  // record the decisions of the following parses in trace (not owned, cleared
+  // at the start of each parse), null to stop
+  void setTrace(ParseTrace *trace);
+  EventReader events(const int argc, const char *argv[]);
+  StreamReader eventStream(void);
+  // parse with the tokens scanned concurrently by nThread threads (0: one per
+  // core), with the same result and warnings as parse
+  bool parseParallel(const int argc, const char *argv[], unsigned int nThread = 0);
+  // split a string into words following POSIX shell quoting rules
+  static Argv splitCommandLine(const std::string &cmdline);
+  // immutable copy of the parse result in one block, and back
+  FrozenResult freeze(void) const;
+  void restore(const FrozenResult &res);
+  // command line reproducing the parse result
+  Argv buildArgv(const std::string progName, const bool omitDefaults = false) const;
+  // checkpoint of the parse result in a file
+  void writeSnapshot(const std::string &path) const;
+  void readSnapshot(const std::string &path);
+  // fingerprint of the option names, types and choices
+  uint64_t schemaHash(void) const;
+  // canonical form and hash of the parse result, for result caching; values of
+  // numeric options (declared, or with an arithmetic validator) are normalised
+  void excludeFromFingerprint(const std::string name);
+  void declareNumeric(const std::string name);
+  std::string canonicalConfig(void) const;
+  Hash128 fingerprint(void) const;
+  // bytes held by the schema, the parse result and the lookup structures
+  MemoryUsage memoryUsage(void) const;
+  // shell completion
+  bool complete(const int argc, const char *argv[], std::ostream &out = std::cout);
+  void writeCompletion(std::ostream &out, const std::string progName,
+                       const Shell shell = Shell::bash) const;
+  // statistics of the last parse, also passed to the hook at the end of each parse;
+  // without OPT_PARSER_STATS they stay at zero and the hook is never called
+  const ParseStats &stats(void) const;
+  void setStatsHook(const std::function<void(const ParseStats &)> hook);
+  // print option list
+  friend std::ostream &operator<<(std::ostream &out, const OptParser &parser);
+
+private:
+  // parse tokens, without program name
+  bool parseTokens(const int n, const char *const *token);
+  // resolve tokens into option and positional events
+  bool scanTokens(const int n, const char *const *token, ParseVisitor &visitor);
+  void scanChunk(const char *const *token, ScanChunk &chunk) const;
+  // default result before parsing, and checks after
+  void resetResult(void);
+  bool checkResult(void);
+  void startStats(void);
+  void endStats(void);
+  // run f(0), ..., f(n - 1) on up to nThread threads, rethrowing the first
+  // exception once all threads are joined
+  static void parallelFor(const unsigned int n, const unsigned int nThread,
+                          const std::function<void(const unsigned int)> &f);
+  // schema access
+  unsigned int optCount(void) const;
+  std::string str(const StrRef &ref) const;
+  bool strEqual(const StrRef &ref, const std::string &s) const;
+  StrRef addStr(const std::string &s);
+  bool isValue(const unsigned int i) const;
+  bool isOptional(const unsigned int i) const;
+  const OptExtra *extra(const unsigned int i) const;
+  OptExtra &addExtra(const unsigned int i);
+  const std::vector<std::string> &choice(const unsigned int i) const;
+  // build lookup structures
+  void buildIndex(void);
+  // find option index
+  int optIndex(const std::string name) const;
+  // add constraint over named options
+  void addConstraint(const Relation type, const int source,
+                     const std::vector<std::string> &name);
+  // run validators on present options, collecting violations
+  bool checkValues(void);
+  // run path checks concurrently, collecting violations in order
+  void checkPaths(const std::vector<PathItem> &item);
+#ifdef OPT_PARSER_POSIX
+  // first failed path check, null if all pass
+  static const char *pathProblem(const std::string &path, const unsigned int check);
+#endif
+  // report violations collected by validators and path checks
+  bool reportViolations(void) const;
+  // check constraints against the options present
+  bool checkConstraints(const Bitset &present) const;
+  // choice index of a value, false with a warning if not an allowed choice
+  bool checkChoice(const unsigned int i, const std::string &value, int &index) const;
+  // set option value, false if not an allowed choice
+  bool setValue(const unsigned int i, const std::string &value);
+  // option name for messages
+  std::string optName(const unsigned int i) const;
+  // split an option token, false if the token is not an option
+  static bool lexOption(const char *arg, OptToken &tok);
+
+private:
+  // schema as a structure of arrays: names and default values are slices of a
+  // single string table, help messages and extra data are only read on demand
+  std::string strTable_;
+  std::vector<StrRef> shortName_, longName_, defaultVal_;
+  std::vector<uint8_t> flag_;
+  std::vector<int> extraIndex_;
+  std::vector<OptExtra> extra_;
+  std::vector<std::string> help_;
+  std::vector<OptRes> result_;
+  std::vector<std::string> arg_, violation_;
+  std::vector<Constraint> constraint_;
+  unsigned int argPathCheck_{0};
+  Bitset mandatory_;
+  NameTrie trie_;
+  bool indexed_{false}, abbrev_{false};
+  ParseTrace *trace_{nullptr};
+  ParseStats stats_;
+  std::chrono::steady_clock::time_point statsStart_;
+  std::function<void(const ParseStats &)> statsHook_;
+};
+
+/******************************************************************************
+ *                         OptParser implementation                           *
+ ******************************************************************************/
+// memory usage ////////////////////////////////////////////////////////////////
+inline std::size_t MemoryUsage::total(void) const
+{
+  return object + names + help + defaults + values + positionals + index + overhead;
+}
+
+inline void MemoryUsage::addBlock(std::size_t &field, const std::size_t size)
+{
+  if (size > 0)
+  {
+    field += size;
+    overhead += blockOverhead(size);
+  }
+}
+
+inline void MemoryUsage::addString(std::size_t &field, const std::string &s)
+{
+  if (isHeap(s))
+  {
+    addBlock(field, s.capacity() + 1);
+  }
+}
+
+inline void MemoryUsage::addStrings(std::size_t &field, const std::vector<std::string> &v)
+{
+  addVector(field, v);
+  for (auto &s : v)
+  {
+    addString(field, s);
+  }
+}
+
+template <typename T>
+void MemoryUsage::addVector(std::size_t &field, const std::vector<T> &v)
+{
+  addBlock(field, v.capacity() * sizeof(T));
+}
+
+inline std::size_t MemoryUsage::blockOverhead(const std::size_t size)
+{
+  const std::size_t align = 2 * sizeof(void *), minBlock = 4 * sizeof(void *);
+  std::size_t block = (size + sizeof(std::size_t) + align - 1) / align * align;
+
+  return std::max(block, minBlock) - size;
+}
+
+inline bool MemoryUsage::isHeap(const std::string &s)
+{
+  const char *p = s.data(), *obj = reinterpret_cast<const char *>(&s);
+
+  return (p < obj) or (p >= obj + sizeof(std::string));
+}
+
+// edit distance ///////////////////////////////////////////////////////////////
+inline EditDistance::EditDistance(const std::string &pattern)
+: pattern_(pattern)
+{
+  std::fill(peq_, peq_ + 256, 0);
+  if (pattern_.size() <= 64)
+  {
+    for (unsigned int i = 0; i < pattern_.size(); ++i)
+    {
+      peq_[static_cast<unsigned char>(pattern_[i])] |= (uint64_t(1) << i);
+    }
+  }
+}
+
+inline unsigned int EditDistance::operator()(const std::string &text,
+                                             const unsigned int max) const
+{
+  return (*this)(text.data(), text.size(), max);
+}
+
+inline unsigned int EditDistance::operator()(const char *text, const std::size_t size,
+                                             const unsigned int max) const
+{
+  const std::size_t m = pattern_.size(), n = size;
+
+  if (((m > n) ? m - n : n - m) > max)
+  {
+    return max + 1;
+  }
+  if (m == 0)
+  {
+    return static_cast<unsigned int>(n);
+  }
+  if (m <= 64)
+  {
+    const uint64_t last = uint64_t(1) << (m - 1);
+    uint64_t pv = ~uint64_t(0), mv = 0;
+    std::size_t score = m;
+
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      uint64_t eq = peq_[static_cast<unsigned char>(text[j])];
+      uint64_t xv = eq | mv, xh = (((eq & pv) + pv) ^ pv) | eq;
+      uint64_t ph = mv | ~(xh | pv), mh = pv & xh;
+
+      if (ph & last)
+      {
+        ++score;
+      }
+      else if (mh & last)
+      {
+        --score;
+      }
+      // the score cannot decrease by more than one per remaining character
+      if (score > max + (n - j - 1))
+      {
+        return max + 1;
+      }
+      ph = (ph << 1) | 1;
+      mh <<= 1;
+      pv = mh | ~(xv | ph);
+      mv = ph & xv;
+    }
+
+    return static_cast<unsigned int>(score);
+  }
+  else
+  {
+    std::vector<std::size_t> d(n + 1);
+
+    for (std::size_t j = 0; j <= n; ++j)
+    {
+      d[j] = j;
+    }
+    for (std::size_t i = 1; i <= m; ++i)
+    {
+      std::size_t diag = d[0];
+
+      d[0] = i;
+      for (std::size_t j = 1; j <= n; ++j)
+      {
+        std::size_t up = d[j];
+
+        d[j] = std::min(std::min(d[j] + 1, d[j - 1] + 1),
+                        diag + ((pattern_[i - 1] == text[j - 1]) ? 0 : 1));
+        diag = up;
+      }
+    }
+
+    return static_cast<unsigned int>(d[n]);
+  }
+}
+
+// bitset //////////////////////////////////////////////////////////////////////
+inline Bitset::Bitset(const std::size_t size)
+: word_((size + 63) / 64, 0), size_(size)
+{}
+
+inline std::size_t Bitset::size(void) const { return size_; }
+
+inline void Bitset::memoryUsage(MemoryUsage &usage, std::size_t &field) const
+{
+  usage.addVector(field, word_);
+}
+
+inline bool Bitset::test(const std::size_t i) const
+{
+  return (word_[i / 64] >> (i % 64)) & 1;
+}
+
+inline void Bitset::set(const std::size_t i, const bool value)
+{
+  if (value)
+  {
+    word_[i / 64] |= (uint64_t(1) << (i % 64));
+  }
+  else
+  {
+    word_[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+}
+
+inline std::size_t Bitset::count(void) const
+{
+  std::size_t n = 0;
+
+  for (auto w : word_)
+  {
+    n += popcount(w);
+  }
+
+  return n;
+}
+
+inline std::size_t Bitset::countAnd(const Bitset &b) const
+{
+  std::size_t n = 0, nw = std::min(word_.size(), b.word_.size());
+
+  for (std::size_t i = 0; i < nw; ++i)
+  {
+    n += popcount(word_[i] & b.word_[i]);
+  }
+
+  return n;
+}
+
+inline bool Bitset::subsetOf(const Bitset &b) const
+{
+  for (std::size_t i = 0; i < word_.size(); ++i)
+  {
+    if (word_[i] & ~((i < b.word_.size()) ? b.word_[i] : 0))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+inline std::vector<unsigned int> Bitset::indices(void) const
+{
+  std::vector<unsigned int> res;
+
+  for (std::size_t i = 0; i < word_.size(); ++i)
+  {
+    for (uint64_t w = word_[i]; w != 0; w &= w - 1)
+    {
+      unsigned int b = 0;
+
+      while (!((w >> b) & 1))
+      {
+        ++b;
+      }
+      res.push_back(static_cast<unsigned int>(64 * i + b));
+    }
+  }
+
+  return res;
+}
+
+inline const std::vector<uint64_t> &Bitset::words(void) const { return word_; }
+
+inline unsigned int Bitset::popcount(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcountll(x));
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+
+  return static_cast<unsigned int>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// perfect hash ////////////////////////////////////////////////////////////////
+inline void PerfectHash::memoryUsage(MemoryUsage &usage, std::size_t &field) const
+{
+  usage.addStrings(field, key_);
+  usage.addVector(field, slot_);
+  usage.addVector(field, seed_);
+}
+
+inline PerfectHash::PerfectHash(const std::vector<std::string> &key)
+: key_(key)
+{
+  const std::size_t n = key_.size(), nBucket = std::max<std::size_t>(1, n / 4);
+  std::vector<std::vector<unsigned int>> bucket(nBucket);
+  std::vector<unsigned int> order(nBucket);
+  std::size_t size = 1;
+  bool done = false;
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    if (std::count(key_.begin(), key_.begin() + i, key_[i]) > 0)
+    {
+      throw(std::logic_error("duplicate key '" + key_[i] + "' in perfect hash"));
+    }
+    bucket[hash(key_[i], 0) % nBucket].push_back(i);
+  }
+  for (unsigned int b = 0; b < nBucket; ++b)
+  {
+    order[b] = b;
+  }
+  std::sort(order.begin(), order.end(), [&bucket](const unsigned int a, const unsigned int b)
+            { return bucket[a].size() > bucket[b].size(); });
+  while (size < 2 * n)
+  {
+    size *= 2;
+  }
+  // largest buckets first, grow the table in the unlikely case a bucket fails
+  while (!done)
+  {
+    mask_ = size - 1;
+    slot_.assign(size, -1);
+    seed_.assign(nBucket, 0);
+    done = true;
+    for (auto b : order)
+    {
+      uint32_t seed = 1;
+      bool fit = false;
+
+      for (; !fit and (seed < (1u << 16)); ++seed)
+      {
+        fit = true;
+        for (unsigned int k = 0; fit and (k < bucket[b].size()); ++k)
+        {
+          uint64_t s = hash(key_[bucket[b][k]], seed) & mask_;
+
+          fit = (slot_[s] < 0);
+          for (unsigned int l = 0; fit and (l < k); ++l)
+          {
+            fit = ((hash(key_[bucket[b][l]], seed) & mask_) != s);
+          }
+        }
+      }
+      if (!fit)
+      {
+        done = false;
+        size *= 2;
+        break;
+      }
+      seed_[b] = --seed;
+      for (auto k : bucket[b])
+      {
+        slot_[hash(key_[k], seed) & mask_] = static_cast<int>(k);
+      }
+    }
+  }
+}
+
+inline int PerfectHash::find(const std::string &str) const
+{
+  if (key_.empty())
+  {
+    return -1;
+  }
+
+  int i = slot_[hash(str, seed_[hash(str, 0) % seed_.size()]) & mask_];
+
+  return ((i >= 0) and (key_[i] == str)) ? i : -1;
+}
+
+inline uint64_t PerfectHash::hash(const std::string &str, const uint64_t seed)
+{
+  // FNV-1a with a seeded basis, followed by the MurmurHash3 finaliser
+  uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+
+  for (char c : str)
+  {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+
+  return h;
+}
+
+// option lexer ////////////////////////////////////////////////////////////////
+// Options are "-n[value]" or "--name[[=]value]", with a one-letter short name, a
+// long name made of letters, '_' and '-', and a value that runs to the end of
+// the token without line breaks; this is the language of the regular expression
+// (-([a-zA-Z])(.+)?)|(--([a-zA-Z_-]+)=?(.+)?) matched without allocation.
+inline bool OptParser::lexOption(const char *arg, OptToken &tok)
+{
+  auto isAlpha = [](const char c)
+  { return ((c >= 'a') and (c <= 'z')) or ((c >= 'A') and (c <= 'Z')); };
+  auto isName = [&isAlpha](const char c)
+  { return isAlpha(c) or (c == '_') or (c == '-'); };
+  const char *p, *q;
+
+  if (arg[0] != '-')
+  {
+    return false;
+  }
+  if (isAlpha(arg[1]))
+  {
+    tok.isLong = false;
+    p = arg + 2;
+  }
+  else if ((arg[1] == '-') and isName(arg[2]))
+  {
+    tok.isLong = true;
+    p = arg + 2;
+    while (isName(*p))
+    {
+      ++p;
+    }
+  }
+  else
+  {
+    return false;
+  }
+  tok.keySize = static_cast<std::size_t>(p - arg);
+  if (tok.isLong and (*p == '='))
+  {
+    ++p;
+  }
+  for (q = p; *q != '\0'; ++q)
+  {
+    if ((*q == '\n') or (*q == '\r'))
+    {
+      return false;
+    }
+  }
+  tok.value = (q > p) ? p : nullptr;
+  tok.valueSize = static_cast<std::size_t>(q - p);
+
+  return true;
+}
+
+// name trie ///////////////////////////////////////////////////////////////////
+// Radix tree: every edge carries a label, and every node caches the index of the
+// only option reachable below it (-1: none, -2: several), so that unique-prefix
+// lookups cost O(key length).
+inline void OptParser::NameTrie::clear(void)
+{
+  node_.clear();
+  node_.emplace_back();
+}
+
+inline void OptParser::NameTrie::insert(const std::string &key, const unsigned int opt)
+{
+  unsigned int n = 0;
+  std::size_t pos = 0;
+
+  if (node_.empty())
+  {
+    clear();
+  }
+  while (pos < key.size())
+  {
+    int c = child(n, key[pos]);
+
+    // new leaf
+    if (c < 0)
+    {
+      auto &ch = node_[n].child;
+      auto it = std::lower_bound(ch.begin(), ch.end(), key[pos],
+                                 [this](const unsigned int i, const char k)
+                                 { return node_[i].label[0] < k; });
+      unsigned int leaf = static_cast<unsigned int>(node_.size());
+
+      ch.insert(it, leaf);
+      node_.emplace_back();
+      node_[leaf].label = key.substr(pos);
+      n = leaf;
+      pos = key.size();
+    }
+    else
+    {
+      const std::string &label = node_[c].label;
+      std::size_t l = 0;
+
+      while ((l < label.size()) and (pos + l < key.size()) and
+             (label[l] == key[pos + l]))
+      {
+        ++l;
+      }
+      // split edge
+      if (l < label.size())
+      {
+        unsigned int mid = static_cast<unsigned int>(node_.size());
+        std::string prefix = label.substr(0, l);
+
+        node_.emplace_back();
+        node_[mid].label = prefix;
+        node_[mid].child.push_back(static_cast<unsigned int>(c));
+        node_[c].label.erase(0, l);
+        std::replace(node_[n].child.begin(), node_[n].child.end(),
+                     static_cast<unsigned int>(c), mid);
+        c = static_cast<int>(mid);
+      }
+      n = static_cast<unsigned int>(c);
+      pos += l;
+    }
+  }
+  node_[n].opt = static_cast<int>(opt);
+}
+
+inline int OptParser::NameTrie::find(const std::string &key) const
+{
+  return find(key.data(), key.size());
+}
+
+inline int OptParser::NameTrie::find(const char *key, const std::size_t size) const
+{
+  bool exact;
+  std::size_t base;
+  int n = walk(key, size, exact, base);
+
+  return ((n >= 0) and exact) ? node_[n].opt : -1;
+}
+
+// exact match, or unique option under the prefix; -2 if ambiguous, in which case
+// the matching keys are returned in candidate (requires seal() after insertions)
+inline int OptParser::NameTrie::findPrefix(const char *key, const std::size_t size,
+                                           std::vector<std::string> &candidate) const
+{
+  bool exact;
+  std::size_t base;
+  int n = walk(key, size, exact, base), opt;
+
+  candidate.clear();
+  if (n < 0)
+  {
+    return -1;
+  }
+  if (exact and (node_[n].opt >= 0))
+  {
+    return node_[n].opt;
+  }
+  opt = node_[n].unique;
+  if (opt == -2)
+  {
+    std::string path = std::string(key, base) + node_[n].label;
+
+    collect(static_cast<unsigned int>(n), path, candidate);
+  }
+
+  return opt;
+}
+
+inline void OptParser::NameTrie::complete(const std::string &prefix,
+                                          std::vector<std::string> &match) const
+{
+  bool exact;
+  std::size_t base;
+  int n = walk(prefix.data(), prefix.size(), exact, base);
+
+  if (n >= 0)
+  {
+    std::string key = prefix.substr(0, base) + node_[n].label;
+
+    collect(static_cast<unsigned int>(n), key, match);
+  }
+}
+
+inline int OptParser::NameTrie::child(const unsigned int n, const char c) const
+{
+  auto &ch = node_[n].child;
+  auto it = std::lower_bound(ch.begin(), ch.end(), c,
+                             [this](const unsigned int i, const char k)
+                             { return node_[i].label[0] < k; });
+
+  return ((it != ch.end()) and (node_[*it].label[0] == c)) ? static_cast<int>(*it)
+                                                            : -1;
+}
+
+// node below which all keys starting with 'key' live, exact is true if 'key'
+// ends on that node; the full key of that node is the first 'base' characters
+// of 'key' followed by the node label, so that lookups do not allocate
+inline int OptParser::NameTrie::walk(const char *key, const std::size_t size, bool &exact,
+                                     std::size_t &base) const
+{
+  int n = node_.empty() ? -1 : 0;
+  std::size_t pos = 0;
+
+  exact = true;
+  base = 0;
+  while ((n >= 0) and (pos < size))
+  {
+    n = child(static_cast<unsigned int>(n), key[pos]);
+    if (n >= 0)
+    {
+      const std::string &label = node_[n].label;
+      std::size_t l = std::min(label.size(), size - pos);
+
+      if (label.compare(0, l, key + pos, l) != 0)
+      {
+        n = -1;
+      }
+      else
+      {
+        exact = (l == label.size());
+        base = pos;
+        pos += l;
+      }
+    }
+  }
+
+  return n;
+}
+
+inline void OptParser::NameTrie::seal(void)
+{
+  if (!node_.empty())
+  {
+    seal(0);
+  }
+}
+
+inline int OptParser::NameTrie::seal(const unsigned int n)
+{
+  int u = node_[n].opt;
+
+  for (auto c : node_[n].child)
+  {
+    int cu = seal(c);
+
+    if ((u == -1) or (cu == -2) or ((cu >= 0) and (u >= 0) and (cu != u)))
+    {
+      u = (u == -1) ? cu : -2;
+    }
+  }
+  node_[n].unique = u;
+
+  return u;
+}
+
+inline void OptParser::NameTrie::memoryUsage(MemoryUsage &usage, std::size_t &field) const
+{
+  usage.addVector(field, node_);
+  for (auto &n : node_)
+  {
+    usage.addString(field, n.label);
+    usage.addVector(field, n.child);
+  }
+}
+
+inline void OptParser::NameTrie::collect(const unsigned int n, std::string &key,
+                                         std::vector<std::string> &match) const
+{
+  if (node_[n].opt >= 0)
+  {
+    match.push_back(key);
+  }
+  for (auto c : node_[n].child)
+  {
+    key += node_[c].label;
+    collect(c, key, match);
+    key.erase(key.size() - node_[c].label.size());
+  }
+}
+
+// access //////////////////////////////////////////////////////////////////////
+inline void OptParser::addOption(const std::string shortName, const std::string longName,
+                                 const OptType type, const bool optional,
+                                 const std::string helpMessage,
+                                 const std::string defaultVal)
+{
+  // the name trie is kept up to date here so that the duplicate check does
+  // not make the schema construction quadratic
+  int i = shortName.empty() ? -1 : trie_.find("-" + shortName);
+
+  if ((i < 0) and !longName.empty())
+  {
+    i = trie_.find("--" + longName);
+  }
+  if (i >= 0)
+  {
+    std::string opt;
+
+    if (shortName_[i].size > 0)
+    {
+      opt += "-" + str(shortName_[i]);
+    }
+    if (!opt.empty())
+    {
+      opt += "/";
+    }
+    if (longName_[i].size > 0)
+    {
+      opt += "--" + str(longName_[i]);
+    }
+    throw(std::logic_error("duplicate option " + opt));
+  }
+  if (!shortName.empty())
+  {
+    trie_.insert("-" + shortName, optCount());
+  }
+  if (!longName.empty())
+  {
+    trie_.insert("--" + longName, optCount());
+  }
+  shortName_.push_back(addStr(shortName));
+  longName_.push_back(addStr(longName));
+  defaultVal_.push_back(addStr(defaultVal));
+  flag_.push_back(((type == OptType::value) ? valueFlag : 0) |
+                  (optional ? optionalFlag : 0));
+  extraIndex_.push_back(-1);
+  help_.push_back(helpMessage);
+  indexed_ = false;
+}
+
+// value option restricted to a set of strings, see optionChoice
+inline void OptParser::addChoice(const std::string shortName, const std::string longName,
+                                 const std::vector<std::string> choice,
+                                 const bool optional, const std::string helpMessage,
+                                 const std::string defaultVal)
+{
+  const std::string name = longName.empty() ? shortName : longName;
+
+  if (choice.empty())
+  {
+    throw(std::logic_error("empty choice list for option '" + name + "'"));
+  }
+
+  std::vector<std::string> sorted(choice);
+
+  std::sort(sorted.begin(), sorted.end());
+
+  auto dup = std::adjacent_find(sorted.begin(), sorted.end());
+
+  if (dup != sorted.end())
+  {
+    throw(std::logic_error("duplicate choice '" + *dup + "' for option '" + name + "'"));
+  }
+
+  PerfectHash hash(choice);
+
+  if (!defaultVal.empty() and (hash.find(defaultVal) < 0))
+  {
+    throw(std::logic_error("default value '" + defaultVal +
+                           "' is not a choice for option '" + name + "'"));
+  }
+  addOption(shortName, longName, OptType::value, optional, helpMessage, defaultVal);
+
+  OptExtra &ex = addExtra(optCount() - 1);
+
+  ex.choice = choice;
+  ex.choiceHash = hash;
+}
+
+// constraints /////////////////////////////////////////////////////////////////
+// if name is present, all the required options must be present
+inline void OptParser::addDependency(const std::string name,
+                                     const std::vector<std::string> required)
+{
+  int i = optIndex(name);
+
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  addConstraint(Relation::dependency, i, required);
+}
+
+// at most one of the options can be present
+inline void OptParser::addConflict(const std::vector<std::string> name)
+{
+  addConstraint(Relation::conflict, -1, name);
+}
+
+// exactly one of the options must be present
+inline void OptParser::addExactlyOne(const std::vector<std::string> name)
+{
+  addConstraint(Relation::exactlyOne, -1, name);
+}
+
+inline void OptParser::addConstraint(const Relation type, const int source,
+                                     const std::vector<std::string> &name)
+{
+  Constraint c;
+
+  c.type = type;
+  c.source = source;
+  for (auto &n : name)
+  {
+    int i = optIndex(n);
+
+    if (i < 0)
+    {
+      throw(std::out_of_range("no option with name '" + n + "'"));
+    }
+    c.opt.push_back(static_cast<unsigned int>(i));
+  }
+  constraint_.push_back(c);
+  indexed_ = false;
+}
+
+// validators //////////////////////////////////////////////////////////////////
+template <typename T>
+void OptParser::Check<T>::run(const std::string &value, const std::string &opt,
+                              std::vector<std::string> &violation) const
+{
+  T x;
+
+  if (!tryStrTo<T>(value, x))
+  {
+    violation.push_back(opt + ": value '" + value + "' is not a valid " + typeName<T>());
+
+    return;
+  }
+  for (auto &v : validator)
+  {
+    if (!v.check(x))
+    {
+      violation.push_back(opt + ": value '" + value + "' " + v.message);
+    }
+  }
+}
+
+template <typename T>
+void OptParser::addValidator(const std::string name, const Validator<T> validator)
+{
+  int i = optIndex(name);
+  std::shared_ptr<Check<T>> check;
+
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  if (!isValue(i))
+  {
+    throw(std::logic_error("option '" + name + "' takes no value"));
+  }
+
+  OptExtra &ex = addExtra(i);
+
+  for (auto &c : ex.check)
+  {
+    if (!check)
+    {
+      check = std::dynamic_pointer_cast<Check<T>>(c);
+    }
+  }
+  if (!check)
+  {
+    check = std::make_shared<Check<T>>();
+    ex.check.push_back(check);
+  }
+  if (std::is_arithmetic<T>::value)
+  {
+    flag_[i] |= numericFlag;
+  }
+  check->validator.push_back(validator);
+}
+
+#ifdef OPT_PARSER_POSIX
+inline void OptParser::addPathCheck(const std::string name, const unsigned int check)
+{
+  int i = optIndex(name);
+
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  if (!isValue(i))
+  {
+    throw(std::logic_error("option '" + name + "' takes no value"));
+  }
+  addExtra(i).pathCheck |= check;
+}
+
+inline void OptParser::addArgPathCheck(const unsigned int check)
+{
+  argPathCheck_ |= check;
+}
+#endif
+
+inline bool OptParser::gotOption(const std::string name) const
+{
+  int i = optIndex(name);
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  if (i >= 0)
+  {
+    return result_[i].present;
+  }
+  else
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+}
+
+template <typename T>
+T OptParser::optionValue(const std::string name) const
+{
+  int i = optIndex(name);
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  if (i >= 0)
+  {
+    return strTo<T>(result_[i].value);
+  }
+  else
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+}
+
+// long option names closest to an unknown name
+inline std::vector<std::string> OptParser::suggest(const std::string name) const
+{
+  std::vector<std::string> res;
+  EditDistance dist(name);
+  unsigned int max = std::max(1u, static_cast<unsigned int>(name.size() / 3));
+
+  for (auto &l : longName_)
+  {
+    if (l.size > 0)
+    {
+      unsigned int d = dist(strTable_.data() + l.offset, l.size, max);
+
+      if (d < max)
+      {
+        res.clear();
+        max = d;
+      }
+      if (d == max)
+      {
+        res.push_back("--" + str(l));
+      }
+    }
+  }
+
+  return res;
+}
+
+// position of the value in the list given to addChoice, as an integer or an
+// enumeration declared in the same order, -1 if the option has no value
+template <typename E>
+E OptParser::optionChoice(const std::string name) const
+{
+  int i = optIndex(name);
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  if (choice(i).empty())
+  {
+    throw(std::logic_error("option '" + name + "' is not a choice"));
+  }
+
+  return static_cast<E>(result_[i].choice);
+}
+
+// modify the parse result, e.g. before buildArgv
+inline void OptParser::setOption(const std::string name, const std::string value)
+{
+  int i = optIndex(name);
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  if (isValue(i))
+  {
+    if (!choice(i).empty() and (extra(i)->choiceHash.find(value) < 0))
+    {
+      throw(std::invalid_argument("'" + value + "' is not a choice for option '" +
+                                  name + "'"));
+    }
+    result_[i].value = value;
+    result_[i].choice = extra(i) ? extra(i)->choiceHash.find(value) : -1;
+  }
+  result_[i].present = true;
+}
+
+inline void OptParser::unsetOption(const std::string name)
+{
+  int i = optIndex(name);
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  result_[i].present = false;
+  result_[i].value = str(defaultVal_[i]);
+  result_[i].choice = extra(i) ? extra(i)->choiceHash.find(result_[i].value) : -1;
+}
+
+inline const std::vector<std::string> &OptParser::getArgs(void) const { return arg_; }
+
+template <typename T>
+std::vector<T> OptParser::getArgs(std::vector<ConversionError> &error,
+                                  unsigned int nThread) const
+{
+  const std::size_t n = arg_.size(), minChunkSize = 4096;
+  std::vector<T> res(n);
+  std::vector<std::vector<ConversionError>> chunkError;
+  unsigned int nChunk;
+
+  if (nThread == 0)
+  {
+    nThread = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // elements of std::vector<bool> share words
+  if (std::is_same<T, bool>::value)
+  {
+    nThread = 1;
+  }
+  nChunk = static_cast<unsigned int>(std::min<std::size_t>(nThread, n / minChunkSize));
+  nChunk = std::max(nChunk, 1u);
+  chunkError.resize(nChunk);
+  parallelFor(nChunk, nThread,
+              [this, n, nChunk, &res, &chunkError](const unsigned int c)
+              {
+                for (std::size_t i = n * c / nChunk; i < n * (c + 1) / nChunk; ++i)
+                {
+                  T x{};
+
+                  if (!tryStrTo<T>(arg_[i], x))
+                  {
+                    chunkError[c].push_back({i, arg_[i]});
+                  }
+                  res[i] = std::move(x);
+                }
+              });
+  error.clear();
+  for (auto &e : chunkError)
+  {
+    error.insert(error.end(), e.begin(), e.end());
+  }
+
+  return res;
+}
+
+template <typename T>
+std::vector<T> OptParser::getArgs(void) const
+{
+  std::vector<ConversionError> error;
+  std::vector<T> res = getArgs<T>(error);
+
+  if (!error.empty())
+  {
+    throw(std::invalid_argument("invalid positional argument " +
+                                strFrom(error[0].index) + " '" + error[0].arg + "'"));
+  }
+
+  return res;
+}
+
+inline const std::vector<std::string> &OptParser::getViolations(void) const
+{
+  return violation_;
+}
+
+inline void OptParser::allowAbbreviation(const bool allow) { abbrev_ = allow; }
+
+inline void OptParser::setTrace(ParseTrace *trace) { trace_ = trace; }
+
+// parse ///////////////////////////////////////////////////////////////////////
+inline bool OptParser::parse(const int argc, const char *argv[])
+{
+  return parseTokens(argc - 1, argv + 1);
+}
+
+// arguments given as one string, without the program name
+inline bool OptParser::parse(const std::string &cmdline)
+{
+  Argv token;
+
+  try
+  {
+    token = splitCommandLine(cmdline);
+  }
+  catch (std::invalid_argument &e)
+  {
+    std::cerr << "warning: " << e.what() << std::endl;
+
+    return false;
+  }
+
+  return parseTokens(token.argc(), token.argv());
+}
+
+// event-driven parse: option values are checked against choices and validators
+// as they come, and the presence of options is tracked in a bitset to check
+// constraints at the end, so memory does not grow with the number of arguments
+// (apart from the values kept for the final batch of path checks)
+inline bool OptParser::parse(const int argc, const char *argv[], ParseVisitor &visitor)
+{
+  CheckVisitor check(*this, visitor);
+  bool isCorrect;
+
+  OPT_PARSER_STAT(startStats());
+  violation_.clear();
+  isCorrect = scanTokens(argc - 1, argv + 1, check);
+  isCorrect &= check.isCorrect;
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(stats_.validateTime));
+    checkPaths(check.path);
+    isCorrect &= reportViolations();
+  }
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(stats_.mandatoryTime));
+    isCorrect &= checkConstraints(check.present);
+  }
+  OPT_PARSER_STAT(endStats());
+
+  return isCorrect;
+}
+
+inline bool OptParser::parseTokens(const int n, const char *const *token)
+{
+  ResultVisitor store(*this);
+  bool isCorrect;
+
+  OPT_PARSER_STAT(startStats());
+  resetResult();
+  isCorrect = scanTokens(n, token, store);
+  isCorrect &= store.isCorrect;
+  isCorrect &= checkResult();
+  OPT_PARSER_STAT(endStats());
+
+  return isCorrect;
+}
+
+inline void OptParser::resetResult(void)
+{
+  result_.clear();
+  result_.resize(optCount());
+  arg_.clear();
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    result_[i].value = str(defaultVal_[i]);
+    result_[i].choice = extra(i) ? extra(i)->choiceHash.find(result_[i].value) : -1;
+  }
+}
+
+inline bool OptParser::checkResult(void)
+{
+  Bitset present(optCount());
+  bool isCorrect;
+
+  isCorrect = checkValues();
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    present.set(i, result_[i].present);
+  }
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(stats_.mandatoryTime));
+    isCorrect &= checkConstraints(present);
+  }
+
+  return isCorrect;
+}
+
+// statistics //////////////////////////////////////////////////////////////////
+inline void OptParser::startStats(void)
+{
+  stats_ = ParseStats();
+  statsStart_ = std::chrono::steady_clock::now();
+}
+
+inline void OptParser::endStats(void)
+{
+  stats_.parseTime = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - statsStart_)
+          .count());
+  if (statsHook_)
+  {
+    statsHook_(stats_);
+  }
+}
+
+inline const ParseStats &OptParser::stats(void) const { return stats_; }
+
+inline void OptParser::setStatsHook(const std::function<void(const ParseStats &)> hook)
+{
+  statsHook_ = hook;
+}
+
+// parallel parse //////////////////////////////////////////////////////////////
+// The tokens are split in chunks scanned concurrently. A chunk can start in two
+// states, depending on whether the previous chunk ends on an option expecting
+// its value, but only the role of its first token depends on it: a positional
+// argument becomes that value, and an option comes after a missing value. Each
+// chunk is then scanned once, with its warnings kept aside, and the chunks are
+// stitched in order, propagating the state and printing the warnings, so that
+// the result and the messages are those of the sequential parse. Positional
+// arguments are finally copied concurrently at offsets known from the stitch.
+inline bool OptParser::parseParallel(const int argc, const char *argv[],
+                                     unsigned int nThread)
+{
+  const int n = argc - 1, minChunkSize = 4096;
+  const char *const *token = argv + 1;
+  ResultVisitor store(*this);
+  std::vector<ScanChunk> chunk;
+  std::size_t nArg = 0;
+  unsigned int nChunk;
+  int expectVal = -1;
+  bool isCorrect = true;
+
+  if (nThread == 0)
+  {
+    nThread = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nChunk = std::min(nThread, static_cast<unsigned int>(n / minChunkSize));
+  // decisions are traced in order by the sequential parse
+  if ((nChunk <= 1) or trace_)
+  {
+    return parseTokens(n, token);
+  }
+  OPT_PARSER_STAT(startStats());
+  buildIndex();
+  resetResult();
+  chunk.resize(nChunk);
+  for (unsigned int c = 0; c < nChunk; ++c)
+  {
+    chunk[c].begin = static_cast<int>(static_cast<int64_t>(n) * c / nChunk);
+    chunk[c].end = static_cast<int>(static_cast<int64_t>(n) * (c + 1) / nChunk);
+  }
+  parallelFor(nChunk, nThread, [this, token, &chunk](const unsigned int c)
+              { scanChunk(token, chunk[c]); });
+  for (auto &ch : chunk)
+  {
+    std::size_t printed = 0;
+
+    ch.skip = 0;
+    if ((expectVal >= 0) and ch.isOption)
+    {
+      std::cerr << "warning: expected value for option " << optName(expectVal);
+      std::cerr << ", got option '" << token[ch.begin] << "' instead" << std::endl;
+      std::cerr.write(ch.log.data(), static_cast<std::streamsize>(ch.firstLogEnd));
+      printed = ch.firstLogEnd;
+      store.option(expectVal, nullptr, 0);
+      isCorrect = false;
+    }
+    else if (expectVal >= 0)
+    {
+      store.option(expectVal, ch.event[0].value, ch.event[0].size);
+      ch.skip = 1;
+    }
+    ch.argOffset = nArg;
+    for (std::size_t e = ch.skip; e < ch.event.size(); ++e)
+    {
+      if (ch.logEnd[e] > printed)
+      {
+        std::cerr.write(ch.log.data() + printed,
+                        static_cast<std::streamsize>(ch.logEnd[e] - printed));
+        printed = ch.logEnd[e];
+      }
+      if (ch.event[e].type == ParseEvent::Type::option)
+      {
+        store.option(ch.event[e].opt, ch.event[e].value, ch.event[e].size);
+      }
+      else
+      {
+        OPT_PARSER_STAT(stats_.byteCopied += ch.event[e].size);
+        nArg++;
+      }
+    }
+    std::cerr.write(ch.log.data() + printed,
+                    static_cast<std::streamsize>(ch.log.size() - printed));
+    isCorrect &= ch.isCorrect;
+    expectVal = ch.expectVal;
+    OPT_PARSER_STAT(stats_ += ch.stats);
+  }
+  if (expectVal >= 0)
+  {
+    std::cerr << "warning: expected value for option " << optName(expectVal) << std::endl;
+    store.option(expectVal, nullptr, 0);
+    isCorrect = false;
+  }
+  // positional arguments, copied concurrently
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(stats_.convertTime));
+    arg_.resize(nArg);
+    parallelFor(nChunk, nThread,
+                [this, &chunk](const unsigned int c)
+                {
+                  std::size_t a = chunk[c].argOffset;
+
+                  for (std::size_t e = chunk[c].skip; e < chunk[c].event.size(); ++e)
+                  {
+                    const ParseEvent &ev = chunk[c].event[e];
+
+                    if (ev.type == ParseEvent::Type::positional)
+                    {
+                      arg_[a++].assign(ev.value, ev.size);
+                    }
+                  }
+                });
+  }
+  isCorrect &= store.isCorrect;
+  isCorrect &= checkResult();
+  OPT_PARSER_STAT(endStats());
+
+  return isCorrect;
+}
+
+// scan a chunk assuming no option expects a value before it
+inline void OptParser::scanChunk(const char *const *token, ScanChunk &chunk) const
+{
+  LogBuffer buf;
+  std::ostream log(&buf);
+  EventReader reader(*this, 0, nullptr);
+  ParseEvent event;
+  OptToken tok;
+
+  reader.log_ = &log;
+  chunk.isOption = lexOption(token[chunk.begin], tok);
+  chunk.event.reserve(static_cast<std::size_t>(chunk.end - chunk.begin));
+  chunk.logEnd.reserve(chunk.event.capacity());
+  for (int t = chunk.begin; t < chunk.end; ++t)
+  {
+    reader.scan(token[t]);
+    if (t == chunk.begin)
+    {
+      chunk.firstLogEnd = buf.log.size();
+    }
+    while (reader.pop(event))
+    {
+      chunk.event.push_back(event);
+      chunk.logEnd.push_back(buf.log.size());
+    }
+  }
+  chunk.expectVal = reader.expectVal_;
+  chunk.isCorrect = reader.isCorrect();
+  OPT_PARSER_STAT(chunk.stats = reader.stats_);
+  chunk.log = std::move(buf.log);
+}
+
+inline OptParser::LogBuffer::int_type OptParser::LogBuffer::overflow(int_type c)
+{
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+  {
+    log.push_back(traits_type::to_char_type(c));
+  }
+
+  return traits_type::not_eof(c);
+}
+
+inline std::streamsize OptParser::LogBuffer::xsputn(const char *s, std::streamsize n)
+{
+  log.append(s, static_cast<std::size_t>(n));
+
+  return n;
+}
+
+inline void OptParser::parallelFor(const unsigned int n, const unsigned int nThread,
+                                   const std::function<void(const unsigned int)> &f)
+{
+  std::atomic<unsigned int> next(0);
+  std::exception_ptr error;
+  std::vector<std::thread> thread;
+  std::atomic_flag failed = ATOMIC_FLAG_INIT;
+  auto work = [&]()
+  {
+    for (unsigned int i = next++; i < n; i = next++)
+    {
+      try
+      {
+        f(i);
+      }
+      catch (...)
+      {
+        if (!failed.test_and_set())
+        {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  for (unsigned int t = 1; t < std::min(n, nThread); ++t)
+  {
+    // run with the threads obtained so far if the system has no more
+    try
+    {
+      thread.emplace_back(work);
+    }
+    catch (std::system_error &)
+    {
+      break;
+    }
+  }
+  work();
+  for (auto &t : thread)
+  {
+    t.join();
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+inline bool OptParser::scanTokens(const int n, const char *const *token,
+                                  ParseVisitor &visitor)
+{
+  EventReader reader(*this, n, token);
+  ParseEvent event;
+
+  buildIndex();
+  while (reader.next(event))
+  {
+    if (event.type == ParseEvent::Type::option)
+    {
+      visitor.option(event.opt, event.value, event.size);
+    }
+    else
+    {
+      visitor.positional(event.value, event.size);
+    }
+  }
+  OPT_PARSER_STAT(stats_ += reader.stats_);
+
+  return reader.isCorrect();
+}
+
+inline OptParser::EventReader OptParser::events(const int argc, const char *argv[])
+{
+  buildIndex();
+
+  return EventReader(*this, argc - 1, argv + 1);
+}
+
+inline OptParser::StreamReader OptParser::eventStream(void)
+{
+  buildIndex();
+
+  return StreamReader(*this);
+}
+
+// pull parser /////////////////////////////////////////////////////////////////
+// Tokens are scanned one at a time when no event is pending; the state carried
+// between tokens is the option waiting for its value, if any.
+inline OptParser::EventReader::EventReader(const OptParser &parser, const int n,
+                                           const char *const *token)
+    : parser_(parser), token_(token), n_(n), trace_(parser.trace_)
+{
+  if (trace_)
+  {
+    trace_->clear();
+  }
+}
+
+inline bool OptParser::EventReader::next(ParseEvent &event)
+{
+  while (!pop(event))
+  {
+    if (t_ > n_)
+    {
+      return false;
+    }
+    if (t_ < n_)
+    {
+      scan(token_[t_]);
+    }
+    else
+    {
+      finish();
+    }
+    ++t_;
+  }
+
+  return true;
+}
+
+inline bool OptParser::EventReader::isCorrect(void) const { return isCorrect_; }
+
+inline OptParser::EventReader::Iterator OptParser::EventReader::begin(void)
+{
+  return Iterator(this);
+}
+
+inline OptParser::EventReader::Iterator OptParser::EventReader::end(void)
+{
+  return Iterator();
+}
+
+inline void OptParser::EventReader::scan(const char *arg)
+{
+  const uint32_t index = index_++;
+  std::vector<std::string> candidate;
+  ParseTrace::Kind kind;
+  OptToken tok;
+  bool isOption;
+  int i = -1;
+
+  OPT_PARSER_STAT(++stats_.token);
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(stats_.tokenizeTime));
+    isOption = lexOption(arg, tok);
+  }
+  // positional argument, or value of the previous option
+  if (!isOption)
+  {
+    if (expectVal_ >= 0)
+    {
+      note(index, ParseTrace::Kind::argument, expectVal_, ParseTrace::Action::value);
+      push(ParseEvent::Type::option, expectVal_, arg, std::strlen(arg));
+      expectVal_ = -1;
+    }
+    else
+    {
+      note(index, ParseTrace::Kind::argument, -1, ParseTrace::Action::positional);
+      push(ParseEvent::Type::positional, 0, arg, std::strlen(arg));
+    }
+
+    return;
+  }
+  kind = tok.isLong ? ParseTrace::Kind::longOption : ParseTrace::Kind::shortOption;
+  // should it be a value?
+  if (expectVal_ >= 0)
+  {
+    *log_ << "warning: expected value for option ";
+    *log_ << parser_.optName(expectVal_);
+    *log_ << ", got option '" << arg << "' instead" << std::endl;
+    note(index, kind, expectVal_, ParseTrace::Action::missingValue);
+    push(ParseEvent::Type::option, expectVal_, nullptr, 0);
+    expectVal_ = -1;
+    isCorrect_ = false;
+  }
+  // short option
+  if (!tok.isLong)
+  {
+    i = lookup(arg, tok.keySize, false, candidate);
+    if (i < 0)
+    {
+      *log_ << "warning: unknown option '" << arg << "'" << std::endl;
+    }
+  }
+  // long option, possibly abbreviated
+  else
+  {
+    i = lookup(arg, tok.keySize, true, candidate);
+    // error if ambiguous
+    if (i == -2)
+    {
+      *log_ << "warning: ambiguous option '" << arg << "', could be ";
+      for (unsigned int c = 0; c < candidate.size(); ++c)
+      {
+        *log_ << ((c > 0) ? ", " : "") << candidate[c];
+      }
+      *log_ << std::endl;
+      isCorrect_ = false;
+    }
+    // warning if not found
+    else if (i < 0)
+    {
+      candidate = parser_.suggest(std::string(arg + 2, tok.keySize - 2));
+      *log_ << "warning: unknown option '" << arg << "'";
+      for (unsigned int c = 0; c < candidate.size(); ++c)
+      {
+        *log_ << ((c > 0) ? ", " : ", did you mean ") << candidate[c];
+      }
+      *log_ << (candidate.empty() ? "" : "?") << std::endl;
+    }
+  }
+  // emit if found, the value may be in the next token
+  if (i >= 0)
+  {
+    if (!parser_.isValue(i))
+    {
+      note(index, kind, i, ParseTrace::Action::option);
+      push(ParseEvent::Type::option, i, nullptr, 0);
+    }
+    else if (tok.value)
+    {
+      note(index, kind, i, ParseTrace::Action::option);
+      push(ParseEvent::Type::option, i, tok.value, tok.valueSize);
+    }
+    else
+    {
+      note(index, kind, i, ParseTrace::Action::expectValue);
+      expectVal_ = i;
+    }
+  }
+  else
+  {
+    note(index, kind, -1,
+         (i == -2) ? ParseTrace::Action::ambiguous : ParseTrace::Action::unknown);
+  }
+}
+
+inline void OptParser::EventReader::note(const uint32_t token,
+                                         const ParseTrace::Kind kind, const int opt,
+                                         const ParseTrace::Action action)
+{
+  if (trace_)
+  {
+    trace_->record(token, kind, opt, action);
+  }
+}
+
+// option index of the key, -2 if it is an ambiguous abbreviation
+inline int OptParser::EventReader::lookup(const char *arg, const std::size_t keySize,
+                                          const bool isLong,
+                                          std::vector<std::string> &candidate)
+{
+  int i;
+
+  OPT_PARSER_STAT(ScopeTimer timer(stats_.lookupTime));
+  OPT_PARSER_STAT(++stats_.lookup);
+  i = (isLong and parser_.abbrev_) ? parser_.trie_.findPrefix(arg, keySize, candidate)
+                                   : parser_.trie_.find(arg, keySize);
+  OPT_PARSER_STAT(stats_.unknown += (i < 0));
+
+  return i;
+}
+
+// end of the command line, the last option may miss its value
+inline void OptParser::EventReader::finish(void)
+{
+  if (expectVal_ >= 0)
+  {
+    *log_ << "warning: expected value for option ";
+    *log_ << parser_.optName(expectVal_) << std::endl;
+    note(index_, ParseTrace::Kind::argument, expectVal_,
+         ParseTrace::Action::missingValue);
+    push(ParseEvent::Type::option, expectVal_, nullptr, 0);
+    expectVal_ = -1;
+    isCorrect_ = false;
+  }
+}
+
+inline bool OptParser::EventReader::pop(ParseEvent &event)
+{
+  if (iPending_ == nPending_)
+  {
+    iPending_ = nPending_ = 0;
+
+    return false;
+  }
+  event = pending_[iPending_++];
+
+  return true;
+}
+
+inline void OptParser::EventReader::push(const ParseEvent::Type type,
+                                         const unsigned int opt, const char *value,
+                                         const std::size_t size)
+{
+  pending_[nPending_++] = {type, opt, value, size};
+}
+
+inline OptParser::EventReader::Iterator::Iterator(EventReader *reader) : reader_(reader)
+{
+  ++(*this);
+}
+
+inline const ParseEvent &OptParser::EventReader::Iterator::operator*(void) const
+{
+  return event_;
+}
+
+inline const ParseEvent *OptParser::EventReader::Iterator::operator->(void) const
+{
+  return &event_;
+}
+
+inline OptParser::EventReader::Iterator &
+OptParser::EventReader::Iterator::operator++(void)
+{
+  if (reader_ and !reader_->next(event_))
+  {
+    reader_ = nullptr;
+  }
+
+  return *this;
+}
+
+inline bool OptParser::EventReader::Iterator::operator==(const Iterator &it) const
+{
+  return reader_ == it.reader_;
+}
+
+inline bool OptParser::EventReader::Iterator::operator!=(const Iterator &it) const
+{
+  return reader_ != it.reader_;
+}
+
+// stream parser ///////////////////////////////////////////////////////////////
+// The chunk is consumed one argument at a time when no event is pending. An
+// argument completed in the chunk is scanned in place; the tail of a chunk is
+// copied to the carry buffer, which the next terminated argument completes.
+inline OptParser::StreamReader::StreamReader(const OptParser &parser)
+    : reader_(parser, 0, nullptr)
+{
+}
+
+inline void OptParser::StreamReader::feed(const char *data, const std::size_t size)
+{
+  if (closed_)
+  {
+    throw(std::logic_error("stream fed after being closed"));
+  }
+  if (pos_ != end_)
+  {
+    throw(std::logic_error("stream fed before the previous chunk was read"));
+  }
+  pos_ = data;
+  end_ = data + size;
+}
+
+inline void OptParser::StreamReader::close(void) { closed_ = true; }
+
+inline bool OptParser::StreamReader::next(ParseEvent &event)
+{
+  while (!reader_.pop(event))
+  {
+    const char *nul;
+
+    if (pos_ == end_)
+    {
+      if (!closed_ or done_)
+      {
+        return false;
+      }
+      if (carry_)
+      {
+        reader_.scan(partial_.c_str());
+        carry_ = false;
+      }
+      reader_.finish();
+      done_ = true;
+      continue;
+    }
+    nul = static_cast<const char *>(
+        std::memchr(pos_, '\0', static_cast<std::size_t>(end_ - pos_)));
+    if (!nul)
+    {
+      if (carry_)
+      {
+        partial_.append(pos_, end_);
+      }
+      else
+      {
+        partial_.assign(pos_, end_);
+        carry_ = true;
+      }
+      pos_ = end_;
+    }
+    else if (carry_)
+    {
+      partial_.append(pos_, nul);
+      pos_ = nul + 1;
+      carry_ = false;
+      reader_.scan(partial_.c_str());
+    }
+    else
+    {
+      reader_.scan(pos_);
+      pos_ = nul + 1;
+    }
+  }
+
+  return true;
+}
+
+inline bool OptParser::StreamReader::done(void) const
+{
+  return done_ and (reader_.iPending_ == reader_.nPending_);
+}
+
+inline bool OptParser::StreamReader::isCorrect(void) const { return reader_.isCorrect(); }
+
+// run validators //////////////////////////////////////////////////////////////
+inline bool OptParser::checkValues(void)
+{
+  OPT_PARSER_STAT(ScopeTimer timer(stats_.validateTime));
+  std::vector<PathItem> path;
+
+  violation_.clear();
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    if (result_[i].present and extra(i))
+    {
+      OPT_PARSER_STAT(stats_.conversion += extra(i)->check.size());
+      for (auto &c : extra(i)->check)
+      {
+        c->run(result_[i].value, optName(i), violation_);
+      }
+      if (extra(i)->pathCheck)
+      {
+        path.push_back({optName(i), result_[i].value, extra(i)->pathCheck});
+      }
+    }
+  }
+  if (argPathCheck_)
+  {
+    for (std::size_t a = 0; a < arg_.size(); ++a)
+    {
+      path.push_back({"argument " + strFrom(a + 1), arg_[a], argPathCheck_});
+    }
+  }
+  checkPaths(path);
+
+  return reportViolations();
+}
+
+// path checks /////////////////////////////////////////////////////////////////
+// Each check is a stat and a few access calls, dominated by the file system
+// latency, so that they are all issued at once from a pool larger than the
+// number of cores. A few paths are checked in the calling thread, where
+// starting threads would cost more than the checks.
+inline void OptParser::checkPaths(const std::vector<PathItem> &item)
+{
+#ifdef OPT_PARSER_POSIX
+  const unsigned int maxThread = 32, minParallel = 8;
+  const unsigned int n = static_cast<unsigned int>(item.size());
+  std::vector<const char *> problem(item.size(), nullptr);
+
+  parallelFor(n, (n < minParallel) ? 1 : maxThread,
+              [&item, &problem](const unsigned int k)
+              { problem[k] = pathProblem(item[k].path, item[k].check); });
+  for (std::size_t k = 0; k < item.size(); ++k)
+  {
+    if (problem[k])
+    {
+      violation_.push_back(item[k].name + ": path '" + item[k].path + "' " + problem[k]);
+    }
+  }
+#else
+  (void)item;
+#endif
+}
+
+#ifdef OPT_PARSER_POSIX
+inline const char *OptParser::pathProblem(const std::string &path,
+                                          const unsigned int check)
+{
+  struct stat st;
+  bool exists = (stat(path.c_str(), &st) == 0);
+
+  if (check & pathCreatable)
+  {
+    std::size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "."
+                      : (slash == 0)               ? "/"
+                                                   : path.substr(0, slash);
+
+    if (exists and (access(path.c_str(), W_OK) != 0))
+    {
+      return "is not writable";
+    }
+    if (!exists and (access(dir.c_str(), W_OK | X_OK) != 0))
+    {
+      return "cannot be created";
+    }
+  }
+  if ((check & ~static_cast<unsigned int>(pathCreatable)) == 0)
+  {
+    return nullptr;
+  }
+  if (!exists)
+  {
+    return "does not exist";
+  }
+  if ((check & pathIsFile) and !S_ISREG(st.st_mode))
+  {
+    return "is not a regular file";
+  }
+  if ((check & pathIsDir) and !S_ISDIR(st.st_mode))
+  {
+    return "is not a directory";
+  }
+  if ((check & pathReadable) and (access(path.c_str(), R_OK) != 0))
+  {
+    return "is not readable";
+  }
+  if ((check & pathWritable) and (access(path.c_str(), W_OK) != 0))
+  {
+    return "is not writable";
+  }
+  if ((check & pathExecutable) and (access(path.c_str(), X_OK) != 0))
+  {
+    return "is not executable";
+  }
+
+  return nullptr;
+}
+#endif
+
+inline bool OptParser::reportViolations(void) const
+{
+  for (auto &v : violation_)
+  {
+    std::cerr << "warning: " << v << std::endl;
+  }
+
+  return violation_.empty();
+}
+
+// check constraints ///////////////////////////////////////////////////////////
+inline bool OptParser::checkConstraints(const Bitset &present) const
+{
+  bool isCorrect = true;
+  auto names = [this](const Bitset &b)
+  {
+    std::string res;
+
+    for (auto i : b.indices())
+    {
+      res += (res.empty() ? "" : ", ") + optName(i);
+    }
+
+    return res;
+  };
+
+  if (!mandatory_.subsetOf(present))
+  {
+    for (auto i : mandatory_.indices())
+    {
+      if (!present.test(i))
+      {
+        std::cerr << "warning: mandatory option " << optName(i);
+        std::cerr << " is missing" << std::endl;
+      }
+    }
+    isCorrect = false;
+  }
+  for (auto &c : constraint_)
+  {
+    switch (c.type)
+    {
+    case Relation::dependency:
+      if (present.test(c.source) and !c.mask.subsetOf(present))
+      {
+        Bitset missing(optCount());
+
+        for (auto i : c.opt)
+        {
+          missing.set(i, !present.test(i));
+        }
+        std::cerr << "warning: option " << optName(c.source);
+        std::cerr << " requires " << names(missing) << std::endl;
+        isCorrect = false;
+      }
+      break;
+    case Relation::conflict:
+      if (c.mask.countAnd(present) > 1)
+      {
+        Bitset given(optCount());
+
+        for (auto i : c.opt)
+        {
+          given.set(i, present.test(i));
+        }
+        std::cerr << "warning: options " << names(given);
+        std::cerr << " are mutually exclusive" << std::endl;
+        isCorrect = false;
+      }
+      break;
+    case Relation::exactlyOne:
+      if (c.mask.countAnd(present) != 1)
+      {
+        std::cerr << "warning: exactly one of the options " << names(c.mask);
+        std::cerr << " is required" << std::endl;
+        isCorrect = false;
+      }
+      break;
+    }
+  }
+
+  return isCorrect;
+}
+
+// shell completion ////////////////////////////////////////////////////////////
+// protocol: prog --complete <cword> <words...>, where words are the words of the
+// command line being completed (program name first) and cword is the index of
+// the word under the cursor. Candidates are written one per line; an empty
+// answer lets the shell fall back to its default (file) completion.
+inline bool OptParser::complete(const int argc, const char *argv[], std::ostream &out)
+{
+  std::vector<std::string> match;
+  std::string cur, prev, optWord, valPrefix;
+  int cword;
+
+  if ((argc < 3) or (std::string(argv[1]) != "--complete"))
+  {
+    return false;
+  }
+  buildIndex();
+  cword = static_cast<int>(strtol(argv[2], (char **)NULL, 10)) + 3;
+  if ((cword >= 3) and (cword < argc))
+  {
+    cur = argv[cword];
+  }
+  if ((cword >= 4) and (cword - 1 < argc))
+  {
+    prev = argv[cword - 1];
+  }
+  // option value: '--opt value', '--opt=value' or, as split by bash,
+  // '--opt', '=', 'value'
+  if (cur == "=")
+  {
+    optWord = prev;
+    cur.clear();
+  }
+  else if ((prev == "=") and (cword >= 5))
+  {
+    optWord = argv[cword - 2];
+  }
+  else if ((cur.compare(0, 2, "--") == 0) and (cur.find('=') != std::string::npos))
+  {
+    optWord = cur.substr(0, cur.find('='));
+    valPrefix = optWord + "=";
+    cur.erase(0, valPrefix.size());
+  }
+  else if (!prev.empty() and (trie_.find(prev) >= 0) and
+           isValue(trie_.find(prev)))
+  {
+    optWord = prev;
+  }
+  if (!optWord.empty())
+  {
+    int i = trie_.find(optWord);
+
+    if (i >= 0)
+    {
+      for (auto &c : choice(i))
+      {
+        if (c.compare(0, cur.size(), cur) == 0)
+        {
+          out << valPrefix << c << "\n";
+        }
+      }
+    }
+
+    return true;
+  }
+  if (!cur.empty() and (cur[0] == '-'))
+  {
+    trie_.complete(cur, match);
+    for (auto &m : match)
+    {
+      out << m << "\n";
+    }
+  }
+
+  return true;
+}
+
+// static completion scripts, answered by the shell without running the program
+inline void OptParser::writeCompletion(std::ostream &out, const std::string progName,
+                                       const Shell shell) const
+{
+  std::string func = "_";
+
+  for (char c : progName)
+  {
+    func += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+  func += "_complete";
+  switch (shell)
+  {
+  case Shell::bash:
+  {
+    std::string names, valueNames, choiceCases;
+
+    for (unsigned int i = 0; i < optCount(); ++i)
+    {
+      std::string n, sName = str(shortName_[i]), lName = str(longName_[i]);
+
+      if (!sName.empty())
+      {
+        n += (n.empty() ? "" : "|") + ("-" + sName);
+      }
+      if (!lName.empty())
+      {
+        n += (n.empty() ? "" : "|") + ("--" + lName);
+      }
+      names += (names.empty() ? "" : " ") + n;
+      if (!choice(i).empty())
+      {
+        std::string words;
+
+        for (auto &c : choice(i))
+        {
+          words += words.empty() ? "" : " ";
+          for (char ch : c)
+          {
+            words += ((ch == '"') or (ch == '$') or (ch == '`') or (ch == '\\'))
+                         ? std::string("\\") + ch
+                         : std::string(1, ch);
+          }
+        }
+        choiceCases += "    " + n + ") COMPREPLY=($(compgen -W \"" + words +
+                       "\" -- \"$cur\")); return 0;;\n";
+      }
+      else if (isValue(i))
+      {
+        valueNames += (valueNames.empty() ? "" : "|") + n;
+      }
+    }
+    std::replace(names.begin(), names.end(), '|', ' ');
+    out << "# bash completion for " << progName << std::endl;
+    out << func << "()" << std::endl;
+    out << "{" << std::endl;
+    out << "  local cur=\"${COMP_WORDS[COMP_CWORD]}\"" << std::endl;
+    out << "  local prev=\"${COMP_WORDS[COMP_CWORD-1]}\"" << std::endl;
+    out << "  COMPREPLY=()" << std::endl;
+    out << "  if [[ \"$cur\" == \"=\" ]]; then" << std::endl;
+    out << "    cur=\"\"" << std::endl;
+    out << "  elif [[ \"$prev\" == \"=\" ]]; then" << std::endl;
+    out << "    prev=\"${COMP_WORDS[COMP_CWORD-2]}\"" << std::endl;
+    out << "  fi" << std::endl;
+    if (!valueNames.empty() or !choiceCases.empty())
+    {
+      out << "  case \"$prev\" in" << std::endl;
+      out << choiceCases;
+      if (!valueNames.empty())
+      {
+        out << "    " << valueNames << ") return 0;;" << std::endl;
+      }
+      out << "  esac" << std::endl;
+    }
+    out << "  if [[ \"$cur\" == -* ]]; then" << std::endl;
+    out << "    COMPREPLY=($(compgen -W \"" << names << "\" -- \"$cur\"))" << std::endl;
+    out << "  fi" << std::endl;
+    out << "}" << std::endl;
+    out << "complete -o default -F " << func << " " << progName << std::endl;
+    break;
+  }
+  case Shell::zsh:
+  {
+    auto quote = [](const std::string &str)
+    {
+      std::string res;
+
+      for (char c : str)
+      {
+        if (c == '\'')
+        {
+          res += "'\\''";
+        }
+        else
+        {
+          if ((c == '[') or (c == ']') or (c == ':') or (c == '\\'))
+          {
+            res += '\\';
+          }
+          res += c;
+        }
+      }
+
+      return res;
+    };
+
+    out << "#compdef " << progName << std::endl;
+    out << "_arguments -s \\" << std::endl;
+    for (unsigned int i = 0; i < optCount(); ++i)
+    {
+      std::string sName = str(shortName_[i]), lName = str(longName_[i]);
+      std::string shortSpec, longSpec, spec;
+      bool value = isValue(i);
+
+      if (!sName.empty())
+      {
+        shortSpec = "-" + sName + (value ? "+" : "");
+      }
+      if (!lName.empty())
+      {
+        longSpec = "--" + lName + (value ? "=" : "");
+      }
+      if (!shortSpec.empty() and !longSpec.empty())
+      {
+        spec = "'(-" + sName + " --" + lName + ")'{" + shortSpec + "," + longSpec + "}'";
+      }
+      else
+      {
+        spec = "'" + shortSpec + longSpec;
+      }
+      spec += "[" + quote(help_[i]) + "]";
+      if (!choice(i).empty())
+      {
+        spec += ":value:(";
+        for (unsigned int c = 0; c < choice(i).size(); ++c)
+        {
+          spec += ((c > 0) ? " " : "") + quote(choice(i)[c]);
+        }
+        spec += ")";
+      }
+      else if (value)
+      {
+        spec += ":value:_files";
+      }
+      out << "  " << spec << "' \\" << std::endl;
+    }
+    out << "  '*:argument:_files'" << std::endl;
+    break;
+  }
+  }
+}
+
+// build lookup structures /////////////////////////////////////////////////////
+inline void OptParser::buildIndex(void)
+{
+  if (indexed_)
+  {
+    return;
+  }
+  trie_.seal();
+  mandatory_ = Bitset(optCount());
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    mandatory_.set(i, !isOptional(i));
+  }
+  for (auto &c : constraint_)
+  {
+    c.mask = Bitset(optCount());
+    for (auto i : c.opt)
+    {
+      c.mask.set(i);
+    }
+  }
+  indexed_ = true;
+}
+
+// find option index ///////////////////////////////////////////////////////////
+// through the name trie used by the parse, which is kept up to date by
+// addOption; when a short and a long name match, the first option wins
+inline int OptParser::optIndex(const std::string name) const
+{
+  int s, l;
+
+  if (name.empty())
+  {
+    return -1;
+  }
+  s = trie_.find("-" + name);
+  l = trie_.find("--" + name);
+
+  return ((s >= 0) and ((l < 0) or (s < l))) ? s : l;
+}
+
+// schema access ///////////////////////////////////////////////////////////////
+inline unsigned int OptParser::optCount(void) const
+{
+  return static_cast<unsigned int>(flag_.size());
+}
+
+inline std::string OptParser::str(const StrRef &ref) const
+{
+  return strTable_.substr(ref.offset, ref.size);
+}
+
+inline bool OptParser::strEqual(const StrRef &ref, const std::string &s) const
+{
+  return (ref.size == s.size()) and (strTable_.compare(ref.offset, ref.size, s) == 0);
+}
+
+inline OptParser::StrRef OptParser::addStr(const std::string &s)
+{
+  StrRef ref;
+
+  if (strTable_.size() + s.size() > UINT32_MAX)
+  {
+    throw(std::length_error("option string table full"));
+  }
+  ref.offset = static_cast<uint32_t>(strTable_.size());
+  ref.size = static_cast<uint32_t>(s.size());
+  strTable_ += s;
+
+  return ref;
+}
+
+inline bool OptParser::isValue(const unsigned int i) const
+{
+  return flag_[i] & valueFlag;
+}
+
+inline bool OptParser::isOptional(const unsigned int i) const
+{
+  return flag_[i] & optionalFlag;
+}
+
+inline const OptParser::OptExtra *OptParser::extra(const unsigned int i) const
+{
+  return (extraIndex_[i] >= 0) ? &extra_[extraIndex_[i]] : nullptr;
+}
+
+inline OptParser::OptExtra &OptParser::addExtra(const unsigned int i)
+{
+  if (extraIndex_[i] < 0)
+  {
+    extraIndex_[i] = static_cast<int>(extra_.size());
+    extra_.emplace_back();
+  }
+
+  return extra_[extraIndex_[i]];
+}
+
+inline const std::vector<std::string> &OptParser::choice(const unsigned int i) const
+{
+  static const std::vector<std::string> none;
+
+  return extra(i) ? extra(i)->choice : none;
+}
+
+// parse statistics ////////////////////////////////////////////////////////////
+inline ParseStats &ParseStats::operator+=(const ParseStats &stats)
+{
+  token += stats.token;
+  lookup += stats.lookup;
+  conversion += stats.conversion;
+  unknown += stats.unknown;
+  byteCopied += stats.byteCopied;
+  tokenizeTime += stats.tokenizeTime;
+  lookupTime += stats.lookupTime;
+  convertTime += stats.convertTime;
+  validateTime += stats.validateTime;
+  mandatoryTime += stats.mandatoryTime;
+  parseTime += stats.parseTime;
+
+  return *this;
+}
+
+inline ScopeTimer::ScopeTimer(uint64_t &ns)
+: ns_(ns), start_(std::chrono::steady_clock::now())
+{}
+
+inline ScopeTimer::~ScopeTimer(void)
+{
+  ns_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start_)
+                                   .count());
+}
+
+// parse trace /////////////////////////////////////////////////////////////////
+// Entries are written at next_ modulo the capacity and next_ is published after
+// the entry, so that a reader interrupting a parse sees complete entries except
+// possibly the oldest one.
+inline void ParseTrace::clear(void) { next_.store(0, std::memory_order_release); }
+
+inline void ParseTrace::record(const uint32_t token, const Kind kind, const int32_t opt,
+                               const Action action)
+{
+  uint64_t n = next_.load(std::memory_order_relaxed);
+
+  entry_[n % capacity] = {token, opt, kind, action};
+  next_.store(n + 1, std::memory_order_release);
+}
+
+inline std::size_t ParseTrace::size(void) const
+{
+  return static_cast<std::size_t>(std::min<uint64_t>(total(), capacity));
+}
+
+inline uint64_t ParseTrace::total(void) const
+{
+  return next_.load(std::memory_order_acquire);
+}
+
+inline const ParseTrace::Entry &ParseTrace::operator[](const std::size_t i) const
+{
+  return entry_[(total() - size() + i) % capacity];
+}
+
+inline void ParseTrace::dump(std::ostream &out) const
+{
+  char line[lineSize];
+
+  for (std::size_t i = 0; i < size(); ++i)
+  {
+    out.write(line, static_cast<std::streamsize>(format((*this)[i], line)));
+  }
+}
+
+#ifdef OPT_PARSER_POSIX
+inline void ParseTrace::dump(const int fd) const
+{
+  char line[lineSize];
+
+  for (std::size_t i = 0; i < size(); ++i)
+  {
+    std::size_t size = format((*this)[i], line), pos = 0;
+
+    while (pos < size)
+    {
+      ssize_t w = write(fd, line + pos, size - pos);
+
+      if ((w < 0) and (errno == EINTR))
+      {
+        continue;
+      }
+      if (w <= 0)
+      {
+        return;
+      }
+      pos += static_cast<std::size_t>(w);
+    }
+  }
+}
+#endif
+
+// "<token> <kind> <action> [<option>]\n", without library calls that could
+// allocate or lock
+inline std::size_t ParseTrace::format(const Entry &e, char *buf)
+{
+  static const char *kindName[] = {"argument", "short-option", "long-option"};
+  static const char *actionName[] = {"positional", "value",         "option",
+                                     "expect-value", "missing-value", "unknown",
+                                     "ambiguous"};
+  std::size_t n = 0;
+  auto put = [buf, &n](const char *s)
+  {
+    while (*s != '\0')
+    {
+      buf[n++] = *s++;
+    }
+  };
+  auto putInt = [buf, &n](uint64_t x)
+  {
+    char digit[20];
+    int d = 0;
+
+    do
+    {
+      digit[d++] = static_cast<char>('0' + x % 10);
+      x /= 10;
+    } while (x > 0);
+    while (d > 0)
+    {
+      buf[n++] = digit[--d];
+    }
+  };
+
+  putInt(e.token);
+  put(" ");
+  put(kindName[static_cast<int>(e.kind)]);
+  put(" ");
+  put(actionName[static_cast<int>(e.action)]);
+  if (e.opt >= 0)
+  {
+    put(" ");
+    putInt(static_cast<uint64_t>(e.opt));
+  }
+  put("\n");
+
+  return n;
+}
+
+// visitors ////////////////////////////////////////////////////////////////////
+inline void ParseVisitor::option(const unsigned int, const char *, const std::size_t) {}
+
+inline void ParseVisitor::positional(const char *, const std::size_t) {}
+
+inline OptParser::ResultVisitor::ResultVisitor(OptParser &parser)
+: parser_(parser)
+{}
+
+inline void OptParser::ResultVisitor::option(const unsigned int opt, const char *value,
+                                             const std::size_t size)
+{
+  OPT_PARSER_STAT(ScopeTimer timer(parser_.stats_.convertTime));
+  parser_.result_[opt].present = true;
+  if (value)
+  {
+    OPT_PARSER_STAT(++parser_.stats_.conversion);
+    OPT_PARSER_STAT(parser_.stats_.byteCopied += size);
+    isCorrect &= parser_.setValue(opt, std::string(value, size));
+  }
+}
+
+inline void OptParser::ResultVisitor::positional(const char *arg, const std::size_t size)
+{
+  OPT_PARSER_STAT(ScopeTimer timer(parser_.stats_.convertTime));
+  OPT_PARSER_STAT(parser_.stats_.byteCopied += size);
+  parser_.arg_.emplace_back(arg, size);
+}
+
+inline OptParser::CheckVisitor::CheckVisitor(OptParser &parser, ParseVisitor &visitor)
+: present(parser.optCount()), parser_(parser), visitor_(visitor)
+{}
+
+inline void OptParser::CheckVisitor::option(const unsigned int opt, const char *value,
+                                            const std::size_t size)
+{
+  present.set(opt);
+  if (value and parser_.extra(opt))
+  {
+    OPT_PARSER_STAT(ScopeTimer timer(parser_.stats_.validateTime));
+    OPT_PARSER_STAT(parser_.stats_.conversion += parser_.extra(opt)->check.size());
+    std::string v(value, size);
+    int index;
+
+    isCorrect &= parser_.checkChoice(opt, v, index);
+    for (auto &c : parser_.extra(opt)->check)
+    {
+      c->run(v, parser_.optName(opt), parser_.violation_);
+    }
+    if (parser_.extra(opt)->pathCheck)
+    {
+      path.push_back({parser_.optName(opt), v, parser_.extra(opt)->pathCheck});
+    }
+  }
+  visitor_.option(opt, value, size);
+}
+
+inline void OptParser::CheckVisitor::positional(const char *arg, const std::size_t size)
+{
+  ++nArg;
+  if (parser_.argPathCheck_)
+  {
+    path.push_back({"argument " + strFrom(nArg), std::string(arg, size),
+                    parser_.argPathCheck_});
+  }
+  visitor_.positional(arg, size);
+}
+
+// set option value ////////////////////////////////////////////////////////////
+inline bool OptParser::setValue(const unsigned int i, const std::string &value)
+{
+  result_[i].value = value;
+
+  return checkChoice(i, value, result_[i].choice);
+}
+
+inline bool OptParser::checkChoice(const unsigned int i, const std::string &value,
+                                   int &index) const
+{
+  index = -1;
+  if (!choice(i).empty())
+  {
+    index = extra(i)->choiceHash.find(value);
+    if (index < 0)
+    {
+      std::cerr << "warning: invalid value '" << value << "' for option ";
+      std::cerr << optName(i) << ", expected one of ";
+      for (unsigned int c = 0; c < choice(i).size(); ++c)
+      {
+        std::cerr << ((c > 0) ? ", " : "") << choice(i)[c];
+      }
+      std::cerr << std::endl;
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// option name for messages ////////////////////////////////////////////////////
+inline std::string OptParser::optName(const unsigned int i) const
+{
+  std::string res = "";
+
+  if (shortName_[i].size > 0)
+  {
+    res += "-" + str(shortName_[i]);
+    if (longName_[i].size > 0)
+    {
+      res += "/";
+    }
+  }
+  if (longName_[i].size > 0)
+  {
+    res += "--" + str(longName_[i]);
+    if (isValue(i))
+    {
+      res += "=";
+    }
+  }
+
+  return res;
+}
+
+// freeze parse result /////////////////////////////////////////////////////////
+inline FrozenResult OptParser::freeze(void) const
+{
+  typedef FrozenResult::Header Header;
+
+  const unsigned int nOpt = optCount(), nArg = static_cast<unsigned int>(arg_.size());
+  const std::size_t nWord = (nOpt + 63) / 64, nStr = 3 * nOpt + nArg;
+  std::vector<uint32_t> offset(nStr + 1);
+  std::size_t dataSize = 0, size;
+  Header h;
+  FrozenResult res;
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  // string offsets
+  for (std::size_t i = 0; i < nStr; ++i)
+  {
+    std::size_t len;
+
+    if (i < nOpt)
+    {
+      len = result_[i].value.size();
+    }
+    else if (i < 2 * nOpt)
+    {
+      len = shortName_[i - nOpt].size;
+    }
+    else if (i < 3 * nOpt)
+    {
+      len = longName_[i - 2 * nOpt].size;
+    }
+    else
+    {
+      len = arg_[i - 3 * nOpt].size();
+    }
+    offset[i] = static_cast<uint32_t>(dataSize);
+    dataSize += len + 1;
+    if (dataSize > UINT32_MAX)
+    {
+      throw(std::length_error("parse result too large to freeze"));
+    }
+  }
+  offset[nStr] = static_cast<uint32_t>(dataSize);
+  // header
+  h.magic = FrozenResult::magic;
+  h.version = FrozenResult::version;
+  h.schema = schemaHash();
+  h.nOpt = nOpt;
+  h.nArg = nArg;
+  h.presence = sizeof(Header);
+  h.choice = static_cast<uint32_t>(h.presence + nWord * sizeof(uint64_t));
+  h.offset = static_cast<uint32_t>(h.choice + nOpt * sizeof(int32_t));
+  h.data = static_cast<uint32_t>(h.offset + (nStr + 1) * sizeof(uint32_t));
+  size = h.data + dataSize;
+  h.size = (size + 7) / 8 * 8;
+  if (h.size > UINT32_MAX)
+  {
+    throw(std::length_error("parse result too large to freeze"));
+  }
+  // fill block
+  std::shared_ptr<char> block(new char[h.size](), std::default_delete<char[]>());
+  char *p = block.get();
+  uint64_t *presence = reinterpret_cast<uint64_t *>(p + h.presence);
+  int32_t *choice = reinterpret_cast<int32_t *>(p + h.choice);
+  char *data = p + h.data;
+
+  std::memcpy(p, &h, sizeof(Header));
+  for (unsigned int i = 0; i < nOpt; ++i)
+  {
+    presence[i / 64] |= static_cast<uint64_t>(result_[i].present) << (i % 64);
+    choice[i] = result_[i].choice;
+  }
+  std::memcpy(p + h.offset, offset.data(), offset.size() * sizeof(uint32_t));
+  for (std::size_t i = 0; i < nStr; ++i)
+  {
+    char *d = data + offset[i];
+
+    if (i < nOpt)
+    {
+      std::memcpy(d, result_[i].value.data(), result_[i].value.size());
+    }
+    else if (i < 3 * nOpt)
+    {
+      const StrRef &r = (i < 2 * nOpt) ? shortName_[i - nOpt] : longName_[i - 2 * nOpt];
+
+      std::memcpy(d, strTable_.data() + r.offset, r.size);
+    }
+    else
+    {
+      std::memcpy(d, arg_[i - 3 * nOpt].data(), arg_[i - 3 * nOpt].size());
+    }
+  }
+  res.owner_ = block;
+  res.data_ = block.get();
+
+  return res;
+}
+
+// restore parse result ////////////////////////////////////////////////////////
+inline void OptParser::restore(const FrozenResult &res)
+{
+  if (res.empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  if ((res.schema() != schemaHash()) or (res.optionCount() != optCount()))
+  {
+    throw(std::runtime_error("parse result does not match the option schema"));
+  }
+  result_.resize(optCount());
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    result_[i].present = res.gotOption(i);
+    result_[i].value.assign(res.optionValue(i), res.optionSize(i));
+    result_[i].choice = res.optionChoice(i);
+  }
+  arg_.resize(res.argCount());
+  for (unsigned int i = 0; i < res.argCount(); ++i)
+  {
+    arg_[i].assign(res.arg(i), res.argSize(i));
+  }
+  violation_.clear();
+}
+
+// split command line //////////////////////////////////////////////////////////
+// Words are separated by blanks and newlines; single quotes keep everything
+// literally; double quotes keep everything but the backslash escapes of '$',
+// '`', '"', '\' and newline; a backslash outside quotes escapes the next
+// character; backslash-newline is a line continuation; '#' at the start of a
+// word comments out the rest of the line. The words are written in one pass
+// into a single buffer, no larger than the input plus one byte.
+inline Argv OptParser::splitCommandLine(const std::string &cmdline)
+{
+  enum
+  {
+    blank,
+    word,
+    single,
+    dbl
+  } state = blank;
+  Argv res;
+  std::vector<std::size_t> start;
+  const std::size_t n = cmdline.size();
+  char *out;
+  std::size_t o = 0;
+
+  res.arena_.resize(n + 1);
+  out = res.arena_.data();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const char c = cmdline[i];
+
+    switch (state)
+    {
+    case blank:
+      if ((c == ' ') or (c == '\t') or (c == '\n'))
+      {
+        break;
+      }
+      if (c == '#')
+      {
+        while ((i + 1 < n) and (cmdline[i + 1] != '\n'))
+        {
+          ++i;
+        }
+        break;
+      }
+      if ((c == '\\') and (i + 1 < n) and (cmdline[i + 1] == '\n'))
+      {
+        ++i;
+        break;
+      }
+      start.push_back(o);
+      state = word;
+      // fall through
+    case word:
+      if ((c == ' ') or (c == '\t') or (c == '\n'))
+      {
+        out[o++] = '\0';
+        state = blank;
+      }
+      else if (c == '\'')
+      {
+        state = single;
+      }
+      else if (c == '"')
+      {
+        state = dbl;
+      }
+      else if (c == '\\')
+      {
+        if (i + 1 == n)
+        {
+          throw(std::invalid_argument("command line ends with an escape character"));
+        }
+        if (cmdline[++i] != '\n')
+        {
+          out[o++] = cmdline[i];
+        }
+      }
+      else
+      {
+        out[o++] = c;
+      }
+      break;
+    case single:
+      if (c == '\'')
+      {
+        state = word;
+      }
+      else
+      {
+        out[o++] = c;
+      }
+      break;
+    case dbl:
+      if (c == '"')
+      {
+        state = word;
+      }
+      else if ((c == '\\') and (i + 1 < n) and
+               (std::strchr("$`\"\\\n", cmdline[i + 1]) != nullptr))
+      {
+        if (cmdline[++i] != '\n')
+        {
+          out[o++] = cmdline[i];
+        }
+      }
+      else
+      {
+        out[o++] = c;
+      }
+      break;
+    }
+  }
+  if ((state == single) or (state == dbl))
+  {
+    throw(std::invalid_argument("unterminated quote in command line"));
+  }
+  if (state == word)
+  {
+    out[o++] = '\0';
+  }
+  res.ptr_.reserve(start.size() + 1);
+  for (auto s : start)
+  {
+    res.ptr_.push_back(out + s);
+  }
+  res.ptr_.push_back(nullptr);
+
+  return res;
+}
+
+// build command line //////////////////////////////////////////////////////////
+// Present options are emitted in schema order, by long name when they have
+// one, followed by the positional arguments. Values are attached to their
+// option ('--name=value', '-nvalue') unless they are empty or contain a line
+// break, which the option syntax cannot carry. Optional values equal to their
+// default are dropped if omitDefaults is set. The strings are written in two
+// passes: one to size the arena, one to fill it.
+inline Argv OptParser::buildArgv(const std::string progName,
+                                 const bool omitDefaults) const
+{
+  Argv res;
+  std::size_t size = 0, nArg = 0;
+  char *p = nullptr;
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    // write one argument made of several pieces
+    auto emit = [&](std::initializer_list<std::pair<const char *, std::size_t>> piece)
+    {
+      if (pass == 1)
+      {
+        res.ptr_.push_back(p);
+      }
+      for (auto &x : piece)
+      {
+        if (pass == 1)
+        {
+          std::memcpy(p, x.first, x.second);
+          p += x.second;
+        }
+        size += x.second;
+      }
+      if (pass == 1)
+      {
+        *(p++) = '\0';
+      }
+      size += 1;
+      nArg += 1;
+    };
+
+    if (pass == 1)
+    {
+      res.arena_.resize(size);
+      res.ptr_.reserve(nArg + 1);
+      p = res.arena_.data();
+    }
+    emit({{progName.data(), progName.size()}});
+    for (unsigned int i = 0; i < optCount(); ++i)
+    {
+      const std::string &v = result_[i].value;
+      const bool isLong = (longName_[i].size > 0);
+      const StrRef &name = isLong ? longName_[i] : shortName_[i];
+      const std::pair<const char *, std::size_t> dash(isLong ? "--" : "-",
+                                                      isLong ? 2 : 1),
+          n(strTable_.data() + name.offset, name.size);
+
+      if (!result_[i].present or
+          (isValue(i) and omitDefaults and isOptional(i) and strEqual(defaultVal_[i], v)))
+      {
+        continue;
+      }
+      if (!isValue(i))
+      {
+        emit({dash, n});
+      }
+      else if (v.empty() or (v.find_first_of("\n\r") != std::string::npos))
+      {
+        emit({dash, n});
+        emit({{v.data(), v.size()}});
+      }
+      else
+      {
+        emit({dash, n, {"=", isLong ? 1 : 0}, {v.data(), v.size()}});
+      }
+    }
+    for (auto &x : arg_)
+    {
+      emit({{x.data(), x.size()}});
+    }
+  }
+  res.ptr_.push_back(nullptr);
+
+  return res;
+}
+
+// snapshot ////////////////////////////////////////////////////////////////////
+inline void OptParser::writeSnapshot(const std::string &path) const
+{
+  freeze().writeSnapshot(path);
+}
+
+inline void OptParser::readSnapshot(const std::string &path)
+{
+  restore(FrozenResult::readSnapshot(path));
+}
+
+// schema fingerprint //////////////////////////////////////////////////////////
+inline uint64_t OptParser::schemaHash(void) const
+{
+  std::string schema;
+
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    schema += str(shortName_[i]) + '\0' + str(longName_[i]) + '\0';
+    // the other flags do not change the parse result
+    schema += static_cast<char>(flag_[i] & (valueFlag | optionalFlag));
+    for (auto &c : choice(i))
+    {
+      schema += c + '\0';
+    }
+    schema += '\n';
+  }
+
+  return PerfectHash::hash(schema, 0);
+}
+
+// configuration fingerprint ///////////////////////////////////////////////////
+// options that do not change results (verbosity, thread count...) are left
+// out of the fingerprint
+inline void OptParser::excludeFromFingerprint(const std::string name)
+{
+  int i = optIndex(name);
+
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  flag_[i] |= noFingerprintFlag;
+}
+
+inline void OptParser::declareNumeric(const std::string name)
+{
+  int i = optIndex(name);
+
+  if (i < 0)
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+  if (!isValue(i))
+  {
+    throw(std::logic_error("option '" + name + "' takes no value"));
+  }
+  flag_[i] |= numericFlag;
+}
+
+// One line per option sorted by name: '--name=value' (or '-n=value' without
+// long name) for value options, with the values of numeric options in a
+// normalised decimal form, and '--name' for present triggers. Positional
+// arguments follow in order as '@index=value'. Backslashes and newlines in
+// values are escaped.
+inline std::string OptParser::canonicalConfig(void) const
+{
+  std::vector<std::pair<std::string, std::string>> entry;
+  std::string res;
+  auto escape = [](const std::string &str)
+  {
+    std::string r;
+
+    for (char c : str)
+    {
+      r += (c == '\\') ? "\\\\" : ((c == '\n') ? "\\n" : std::string(1, c));
+    }
+
+    return r;
+  };
+  auto normalise = [](const std::string &str)
+  {
+    const char *b = str.c_str();
+    char *e;
+    std::size_t digit = (b[0] == '-' or b[0] == '+') ? 1 : 0;
+    char buf[32];
+
+    // decimal notation only, hexadecimal, infinities and NaNs are kept as given
+    if (str.empty() or (str.find_first_not_of("0123456789+-.eE") != std::string::npos))
+    {
+      return str;
+    }
+    if ((digit < str.size()) and
+        (str.find_first_not_of("0123456789", digit) == std::string::npos))
+    {
+      errno = 0;
+      long long n = std::strtoll(b, &e, 10);
+
+      if (errno == 0)
+      {
+        std::snprintf(buf, sizeof(buf), "%lld", n);
+
+        return std::string(buf);
+      }
+    }
+
+    double x = std::strtod(b, &e);
+
+    if ((*e != '\0') or (e == b))
+    {
+      return str;
+    }
+    std::snprintf(buf, sizeof(buf), "%.17g", (x == 0.) ? 0. : x);
+
+    return std::string(buf);
+  };
+
+  if (result_.size() != optCount())
+  {
+    throw(std::runtime_error("options not parsed"));
+  }
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    std::string key = (longName_[i].size > 0) ? "--" + str(longName_[i])
+                                              : "-" + str(shortName_[i]);
+
+    if (flag_[i] & noFingerprintFlag)
+    {
+      continue;
+    }
+    if (isValue(i))
+    {
+      const std::string &v = result_[i].value;
+
+      entry.emplace_back(key, "=" + escape((flag_[i] & numericFlag) ? normalise(v) : v));
+    }
+    else if (result_[i].present)
+    {
+      entry.emplace_back(key, "");
+    }
+  }
+  std::sort(entry.begin(), entry.end());
+  for (auto &e : entry)
+  {
+    res += e.first + e.second + "\n";
+  }
+  for (unsigned int i = 0; i < arg_.size(); ++i)
+  {
+    res += "@" + strFrom(i) + "=" + escape(arg_[i]) + "\n";
+  }
+
+  return res;
+}
+
+inline Hash128 OptParser::fingerprint(void) const
+{
+  std::string c = canonicalConfig();
+
+  return hash128(c.data(), c.size());
+}
+
+// memory usage ////////////////////////////////////////////////////////////////
+// Names and default values are slices of the string table, whose separators
+// and spare capacity count as overhead.
+inline MemoryUsage OptParser::memoryUsage(void) const
+{
+  MemoryUsage usage;
+  std::size_t nameSize = 0, defaultSize = 0;
+
+  usage.object = sizeof(OptParser);
+  for (unsigned int i = 0; i < optCount(); ++i)
+  {
+    nameSize += shortName_[i].size + longName_[i].size;
+    defaultSize += defaultVal_[i].size;
+  }
+  if (MemoryUsage::isHeap(strTable_))
+  {
+    usage.names += nameSize;
+    usage.defaults += defaultSize;
+    usage.overhead += strTable_.capacity() + 1 - nameSize - defaultSize +
+                      MemoryUsage::blockOverhead(strTable_.capacity() + 1);
+  }
+  usage.addVector(usage.names, shortName_);
+  usage.addVector(usage.names, longName_);
+  usage.addVector(usage.defaults, defaultVal_);
+  usage.addStrings(usage.help, help_);
+  // parse result
+  usage.addVector(usage.values, result_);
+  for (auto &r : result_)
+  {
+    usage.addString(usage.values, r.value);
+  }
+  usage.addStrings(usage.values, violation_);
+  usage.addStrings(usage.positionals, arg_);
+  // lookup structures
+  usage.addVector(usage.index, flag_);
+  usage.addVector(usage.index, extraIndex_);
+  usage.addVector(usage.index, extra_);
+  for (auto &e : extra_)
+  {
+    usage.addStrings(usage.index, e.choice);
+    e.choiceHash.memoryUsage(usage, usage.index);
+    usage.addVector(usage.index, e.check);
+  }
+  usage.addVector(usage.index, constraint_);
+  for (auto &c : constraint_)
+  {
+    usage.addVector(usage.index, c.opt);
+    c.mask.memoryUsage(usage, usage.index);
+  }
+  mandatory_.memoryUsage(usage, usage.index);
+  trie_.memoryUsage(usage, usage.index);
+
+  return usage;
+}
+
+// print option list ///////////////////////////////////////////////////////////
+std::ostream &operator<<(std::ostream &out, const OPT_PARSER_NS::OptParser &parser);
+
+inline std::ostream &operator<<(std::ostream &out, const OPT_PARSER_NS::OptParser &parser)
+{
+  for (unsigned int i = 0; i < parser.optCount(); ++i)
+  {
+    auto &choice = parser.choice(i);
+
+    out << std::setw(20) << parser.optName(i);
+    out << ": " << parser.help_[i];
+    if (!choice.empty())
+    {
+      out << " (";
+      for (unsigned int c = 0; c < choice.size(); ++c)
+      {
+        out << ((c > 0) ? "|" : "") << choice[c];
+      }
+      out << ")";
+    }
+    if (parser.defaultVal_[i].size > 0)
+    {
+      out << " (default: " << parser.str(parser.defaultVal_[i]) << ")";
+    }
+    out << std::endl;
+  }
+
+  return out;
+}
+
+/******************************************************************************
+ *                           Argv implementation                              *
+ ******************************************************************************/
+inline int Argv::argc(void) const
+{
+  return ptr_.empty() ? 0 : static_cast<int>(ptr_.size() - 1);
+}
+
+inline char **Argv::argv(void) { return ptr_.data(); }
+
+inline std::string Argv::str(void) const
+{
+  static const char safe[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                             "0123456789_@%+=:,./-";
+  std::string res;
+
+  for (int i = 0; i < argc(); ++i)
+  {
+    const char *a = ptr_[i];
+    std::size_t n = std::strlen(a);
+
+    res += (i > 0) ? " " : "";
+    if ((n > 0) and (std::strspn(a, safe) == n))
+    {
+      res.append(a, n);
+    }
+    else
+    {
+      res += '\'';
+      for (std::size_t j = 0; j < n; ++j)
+      {
+        res += (a[j] == '\'') ? std::string("'\\''") : std::string(1, a[j]);
+      }
+      res += '\'';
+    }
+  }
+
+  return res;
+}
+
+/******************************************************************************
+ *                       FrozenResult implementation                          *
+ ******************************************************************************/
+// access by index /////////////////////////////////////////////////////////////
+inline unsigned int FrozenResult::optionCount(void) const
+{
+  return empty() ? 0 : header().nOpt;
+}
+
+inline bool FrozenResult::gotOption(const unsigned int i) const
+{
+  checkOption(i);
+
+  const uint64_t *presence =
+      reinterpret_cast<const uint64_t *>(data_ + header().presence);
+
+  return (presence[i / 64] >> (i % 64)) & 1;
+}
+
+inline const char *FrozenResult::optionValue(const unsigned int i) const
+{
+  checkOption(i);
+
+  return str(i);
+}
+
+inline std::size_t FrozenResult::optionSize(const unsigned int i) const
+{
+  checkOption(i);
+
+  return strSize(i);
+}
+
+inline int FrozenResult::optionChoice(const unsigned int i) const
+{
+  checkOption(i);
+
+  return reinterpret_cast<const int32_t *>(data_ + header().choice)[i];
+}
+
+inline unsigned int FrozenResult::argCount(void) const
+{
+  return empty() ? 0 : header().nArg;
+}
+
+inline const char *FrozenResult::arg(const unsigned int i) const
+{
+  checkArg(i);
+
+  return str(3 * header().nOpt + i);
+}
+
+inline std::size_t FrozenResult::argSize(const unsigned int i) const
+{
+  checkArg(i);
+
+  return strSize(3 * header().nOpt + i);
+}
+
+// access by name //////////////////////////////////////////////////////////////
+inline int FrozenResult::optIndex(const std::string &name) const
+{
+  const unsigned int nOpt = optionCount();
+
+  for (unsigned int i = 0; i < nOpt; ++i)
+  {
+    const unsigned int s = nOpt + i, l = 2 * nOpt + i;
+
+    if (((strSize(s) == name.size()) and (name.compare(str(s)) == 0)) or
+        ((strSize(l) == name.size()) and (name.compare(str(l)) == 0)))
+    {
+      return static_cast<int>(i);
     }
-    out << std::endl;
   }
 
-  return out;
+  return -1;
+}
+
+inline bool FrozenResult::gotOption(const std::string name) const
+{
+  return gotOption(checkedIndex(name));
+}
+
+template <typename T>
+T FrozenResult::optionValue(const std::string name) const
+{
+  unsigned int i = checkedIndex(name);
+
+  return strTo<T>(std::string(optionValue(i), optionSize(i)));
+}
+
+template <typename E>
+E FrozenResult::optionChoice(const std::string name) const
+{
+  return static_cast<E>(optionChoice(checkedIndex(name)));
+}
+
+inline std::vector<std::string> FrozenResult::getArgs(void) const
+{
+  std::vector<std::string> res;
+
+  for (unsigned int i = 0; i < argCount(); ++i)
+  {
+    res.emplace_back(arg(i), argSize(i));
+  }
+
+  return res;
+}
+
+// raw block ///////////////////////////////////////////////////////////////////
+inline bool FrozenResult::empty(void) const { return (data_ == nullptr); }
+
+inline const char *FrozenResult::data(void) const { return data_; }
+
+inline std::size_t FrozenResult::size(void) const
+{
+  return empty() ? 0 : static_cast<std::size_t>(header().size);
+}
+
+inline uint64_t FrozenResult::schema(void) const { return empty() ? 0 : header().schema; }
+
+// the block is a single allocation (or mapping) shared through owner_
+inline MemoryUsage FrozenResult::memoryUsage(void) const
+{
+  MemoryUsage usage;
+
+  usage.object = sizeof(FrozenResult);
+  if (!empty())
+  {
+    const unsigned int nOpt = optionCount();
+
+    usage.index = header().data;
+    for (unsigned int i = 0; i < 3 * nOpt + argCount(); ++i)
+    {
+      std::size_t &field =
+          (i < nOpt) ? usage.values : ((i < 3 * nOpt) ? usage.names : usage.positionals);
+
+      field += strSize(i) + 1;
+    }
+    // alignment padding, allocator and shared control block
+    usage.overhead = size() - usage.index - usage.values - usage.names -
+                     usage.positionals + MemoryUsage::blockOverhead(size()) +
+                     4 * sizeof(void *);
+  }
+
+  return usage;
+}
+
+// binary serialisation ////////////////////////////////////////////////////////
+inline std::string FrozenResult::serialize(void) const
+{
+  return std::string(data(), size());
+}
+
+inline FrozenResult FrozenResult::deserialize(const void *data, const std::size_t size)
+{
+  FrozenResult res;
+
+  if (size < sizeof(Header))
+  {
+    throw(std::runtime_error("invalid parse result blob: truncated header"));
+  }
+  // copy to an aligned block before reading any field
+  std::shared_ptr<char> block(new char[size], std::default_delete<char[]>());
+
+  std::memcpy(block.get(), data, size);
+  validate(block.get(), size);
+  res.owner_ = block;
+  res.data_ = block.get();
+
+  return res;
+}
+
+inline FrozenResult FrozenResult::deserialize(const std::string &blob)
+{
+  return deserialize(blob.data(), blob.size());
+}
+
+#ifdef OPT_PARSER_POSIX
+// shared memory ///////////////////////////////////////////////////////////////
+// The segment is recreated rather than overwritten, so that processes still
+// attached to a previous version keep a consistent mapping, and the magic
+// number is written last, so that a partially written block is never valid.
+// Between the unlink and the magic number, the name is missing, empty or
+// holds a block without magic number: attach retries on these states.
+inline void FrozenResult::publish(const std::string &name) const
+{
+  int fd;
+  void *p;
+  auto fail = [&name](const std::string &call)
+  {
+    throw(std::runtime_error(call + " failed for shared memory '" + name +
+                             "': " + std::strerror(errno)));
+  };
+
+  if (empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  shm_unlink(name.c_str());
+  fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    fail("shm_open");
+  }
+  if (ftruncate(fd, static_cast<off_t>(size())) != 0)
+  {
+    close(fd);
+    fail("ftruncate");
+  }
+  p = mmap(nullptr, size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+  {
+    fail("mmap");
+  }
+  std::memcpy(static_cast<char *>(p) + sizeof(uint32_t), data_ + sizeof(uint32_t),
+              size() - sizeof(uint32_t));
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(p, data_, sizeof(uint32_t));
+  munmap(p, size());
+}
+
+inline FrozenResult FrozenResult::attach(const std::string &name)
+{
+  FrozenResult res;
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(static_cast<long>(attachTimeout));
+  auto fail = [&name](const std::string &call)
+  {
+    throw(std::runtime_error(call + " failed for shared memory '" + name +
+                             "': " + std::strerror(errno)));
+  };
+
+  while (true)
+  {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat st;
+    std::size_t size = 0;
+    void *p;
+
+    if ((fd < 0) and (errno != ENOENT))
+    {
+      fail("shm_open");
+    }
+    if (fd >= 0)
+    {
+      if (fstat(fd, &st) != 0)
+      {
+        close(fd);
+        fail("fstat");
+      }
+      size = static_cast<std::size_t>(st.st_size);
+    }
+    if (size >= sizeof(Header))
+    {
+      p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (p == MAP_FAILED)
+      {
+        fail("mmap");
+      }
+      std::shared_ptr<const void> owner(p, [size](const void *q)
+                                        { munmap(const_cast<void *>(q), size); });
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (*static_cast<const uint32_t *>(p) == magic)
+      {
+        validate(static_cast<const char *>(p), size);
+        res.owner_ = owner;
+        res.data_ = static_cast<const char *>(p);
+
+        return res;
+      }
+    }
+    else if (fd >= 0)
+    {
+      close(fd);
+    }
+    // missing, empty or not yet complete
+    if (std::chrono::steady_clock::now() >= deadline)
+    {
+      if (fd < 0)
+      {
+        errno = ENOENT;
+        fail("shm_open");
+      }
+      throw(std::runtime_error("shared memory '" + name + "' holds no parse result"));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+inline void FrozenResult::unpublish(const std::string &name) { shm_unlink(name.c_str()); }
+#endif
+
+// snapshot ////////////////////////////////////////////////////////////////////
+// Written to a temporary file with a unique name, which is renamed over the
+// target, so that an interrupted checkpoint never leaves a truncated snapshot
+// behind and concurrent writers do not mix their data. On POSIX systems the
+// file is synced before the rename and its directory after, so that this also
+// holds across a power loss.
+inline void FrozenResult::writeSnapshot(const std::string &path) const
+{
+  static std::atomic<unsigned int> counter{0};
+  SnapshotHeader h;
+  std::string tmp;
+  bool ok;
+
+  if (empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  h.magic = snapshotMagic;
+  h.version = snapshotVersion;
+  h.checksum = checksum(data(), size());
+  h.size = size();
+  h.reserved = 0;
+#ifdef OPT_PARSER_POSIX
+  auto writeAll = [](const int fd, const char *buf, std::size_t n)
+  {
+    while (n > 0)
+    {
+      ssize_t w = write(fd, buf, n);
+
+      if ((w < 0) and (errno == EINTR))
+      {
+        continue;
+      }
+      if (w <= 0)
+      {
+        return false;
+      }
+      buf += w;
+      n -= static_cast<std::size_t>(w);
+    }
+
+    return true;
+  };
+  std::size_t slash = path.find_last_of('/');
+  std::string dir = (slash == std::string::npos)
+                        ? "."
+                        : ((slash == 0) ? "/" : path.substr(0, slash));
+  int fd;
+
+  tmp = path + ".tmp." + strFrom(getpid()) + "." + strFrom(counter++);
+  fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+  ok = (fd >= 0) and
+       writeAll(fd, reinterpret_cast<const char *>(&h), sizeof(SnapshotHeader)) and
+       writeAll(fd, data(), size()) and (fsync(fd) == 0);
+  if ((fd >= 0) and (close(fd) != 0))
+  {
+    ok = false;
+  }
+  ok = ok and (std::rename(tmp.c_str(), path.c_str()) == 0);
+  if (ok)
+  {
+    fd = open(dir.c_str(), O_RDONLY);
+    ok = (fd >= 0) and (fsync(fd) == 0);
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+  }
+#else
+  tmp = path + ".tmp." + strFrom(counter++);
+  {
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+
+    file.write(reinterpret_cast<const char *>(&h), sizeof(SnapshotHeader));
+    file.write(data(), static_cast<std::streamsize>(size()));
+    file.close();
+    ok = file and (std::rename(tmp.c_str(), path.c_str()) == 0);
+  }
+#endif
+  if (!ok)
+  {
+    std::remove(tmp.c_str());
+    throw(std::runtime_error("cannot write snapshot '" + path + "'"));
+  }
+}
+
+// the file is memory-mapped where possible, the result then reads the mapping
+inline FrozenResult FrozenResult::readSnapshot(const std::string &path)
+{
+  FrozenResult res;
+  std::shared_ptr<const void> owner;
+  const char *p = nullptr;
+  std::size_t size = 0;
+  SnapshotHeader h;
+
+#ifdef OPT_PARSER_POSIX
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+
+  if ((fd >= 0) and (fstat(fd, &st) == 0) and (st.st_size > 0))
+  {
+    void *m;
+
+    size = static_cast<std::size_t>(st.st_size);
+    m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED)
+    {
+      owner.reset(m, [size](const void *q) { munmap(const_cast<void *>(q), size); });
+      p = static_cast<const char *>(m);
+    }
+  }
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+#endif
+  if (p == nullptr)
+  {
+    std::ifstream file(path, std::ios::binary);
+    std::string buf((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+
+    if (!file)
+    {
+      throw(std::runtime_error("cannot read snapshot '" + path + "'"));
+    }
+    size = buf.size();
+    std::shared_ptr<char> block(new char[size + 1], std::default_delete<char[]>());
+    std::memcpy(block.get(), buf.data(), size);
+    owner = block;
+    p = block.get();
+  }
+  if (size < sizeof(SnapshotHeader))
+  {
+    throw(std::runtime_error("snapshot '" + path + "' is truncated"));
+  }
+  std::memcpy(&h, p, sizeof(SnapshotHeader));
+  if (h.magic != snapshotMagic)
+  {
+    throw(std::runtime_error("'" + path + "' is not a parse result snapshot"));
+  }
+  if (h.version != snapshotVersion)
+  {
+    throw(std::runtime_error("snapshot '" + path + "' has unsupported version " +
+                             strFrom(h.version)));
+  }
+  if ((h.size < sizeof(Header)) or (h.size > size - sizeof(SnapshotHeader)) or
+      (checksum(p + sizeof(SnapshotHeader), h.size) != h.checksum))
+  {
+    throw(std::runtime_error("snapshot '" + path + "' is corrupted"));
+  }
+  p += sizeof(SnapshotHeader);
+  validate(p, h.size);
+  res.owner_ = owner;
+  res.data_ = p;
+
+  return res;
+}
+
+// FNV-1a over 64-bit words, then over the remaining bytes
+inline uint64_t FrozenResult::checksum(const char *data, const std::size_t size)
+{
+  uint64_t h = 14695981039346656037ull, w;
+  std::size_t i = 0;
+
+  for (; i + 8 <= size; i += 8)
+  {
+    std::memcpy(&w, data + i, 8);
+    h ^= w;
+    h *= 1099511628211ull;
+    h ^= h >> 29;
+  }
+  for (; i < size; ++i)
+  {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ull;
+  }
+
+  return h;
+}
+
+// check that a block is consistent before using it, data must be 8-byte aligned
+inline void FrozenResult::validate(const char *data, const std::size_t size)
+{
+  const Header &h = *reinterpret_cast<const Header *>(data);
+  const uint64_t nWord = (uint64_t(h.nOpt) + 63) / 64,
+                 nStr = 3 * uint64_t(h.nOpt) + h.nArg;
+  const uint32_t *offset;
+  auto fail = [](const std::string &msg)
+  { throw(std::runtime_error("invalid parse result blob: " + msg)); };
+
+  if ((size < sizeof(Header)) or (h.magic != magic))
+  {
+    fail("bad magic number");
+  }
+  if (h.version != version)
+  {
+    fail("unsupported version " + strFrom(h.version));
+  }
+  if (h.size > size)
+  {
+    fail("truncated block");
+  }
+  if ((h.presence != sizeof(Header)) or (h.choice != h.presence + 8 * nWord) or
+      (h.offset != h.choice + 4 * uint64_t(h.nOpt)) or
+      (h.data != h.offset + 4 * (nStr + 1)) or (h.data > h.size))
+  {
+    fail("inconsistent layout");
+  }
+  offset = reinterpret_cast<const uint32_t *>(data + h.offset);
+  if ((offset[0] != 0) or (h.data + uint64_t(offset[nStr]) > h.size))
+  {
+    fail("string data out of bounds");
+  }
+  for (uint64_t i = 0; i < nStr; ++i)
+  {
+    if ((offset[i + 1] <= offset[i]) or (data[h.data + offset[i + 1] - 1] != '\0'))
+    {
+      fail("corrupted string table");
+    }
+  }
+}
+
+// internal access /////////////////////////////////////////////////////////////
+inline const FrozenResult::Header &FrozenResult::header(void) const
+{
+  return *reinterpret_cast<const Header *>(data_);
+}
+
+inline const uint32_t *FrozenResult::offset(void) const
+{
+  return reinterpret_cast<const uint32_t *>(data_ + header().offset);
+}
+
+inline const char *FrozenResult::str(const unsigned int i) const
+{
+  return data_ + header().data + offset()[i];
+}
+
+inline std::size_t FrozenResult::strSize(const unsigned int i) const
+{
+  return offset()[i + 1] - offset()[i] - 1;
+}
+
+inline unsigned int FrozenResult::checkedIndex(const std::string &name) const
+{
+  int i;
+
+  if (empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  i = optIndex(name);
+  if ((i < 0) or (static_cast<unsigned int>(i) >= header().nOpt))
+  {
+    throw(std::out_of_range("no option with name '" + name + "'"));
+  }
+
+  return static_cast<unsigned int>(i);
+}
+
+inline void FrozenResult::checkOption(const unsigned int i) const
+{
+  if (empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  if (i >= header().nOpt)
+  {
+    throw(std::out_of_range("option index " + strFrom(i) + " out of range"));
+  }
+}
+
+inline void FrozenResult::checkArg(const unsigned int i) const
+{
+  if (empty())
+  {
+    throw(std::runtime_error("empty parse result"));
+  }
+  if (i >= header().nArg)
+  {
+    throw(std::out_of_range("argument index " + strFrom(i) + " out of range"));
+  }
 }
 
 } // namespace OPT_PARSER_NS
@@ -0,0 +1,67 @@
+#include <OptParser.hpp>
+
+using namespace std;
+using namespace optp;
+
+// option names cannot contain digits, spell the index in letters
+static string name(unsigned int i)
+{
+  string s;
+
+  do
+  {
+    s += static_cast<char>('a' + i % 26);
+    i /= 26;
+  } while (i > 0);
+
+  return "option-" + s;
+}
+
+static void makeSchema(OptParser &opt, const unsigned int nOpt)
+{
+  for (unsigned int i = 0; i < nOpt; ++i)
+  {
+    opt.addOption("", name(i), OptParser::OptType::value, true,
+                  "help message for " + name(i), to_string(i));
+  }
+}
+
+static void print(const string &title, const unsigned int nOpt, const MemoryUsage &usage)
+{
+  printf("%-8s %6u %8zu %8zu %8zu %8zu %8zu %8zu %8zu %8zu %9zu\n", title.c_str(), nOpt,
+         usage.object, usage.names, usage.help, usage.defaults, usage.values,
+         usage.positionals, usage.index, usage.overhead, usage.total());
+}
+
+int main(void)
+{
+  printf("%-8s %6s %8s %8s %8s %8s %8s %8s %8s %8s %9s\n", "", "nOpt", "object", "names",
+         "help", "defaults", "values", "args", "index", "overhead", "total");
+  for (unsigned int nOpt : {10u, 100u, 1000u, 10000u})
+  {
+    OptParser opt;
+    vector<string> token;
+    vector<const char *> argv = {"memory"};
+
+    makeSchema(opt, nOpt);
+    print("schema", nOpt, opt.memoryUsage());
+    // every tenth option set, as many positional arguments
+    for (unsigned int i = 0; i < nOpt; i += 10)
+    {
+      token.push_back("--" + name(i) + "=value");
+      token.push_back("argument-" + to_string(i));
+    }
+    for (auto &t : token)
+    {
+      argv.push_back(t.c_str());
+    }
+    if (!opt.parse(static_cast<int>(argv.size()), argv.data()))
+    {
+      return EXIT_FAILURE;
+    }
+    print("parsed", nOpt, opt.memoryUsage());
+    print("frozen", nOpt, opt.freeze().memoryUsage());
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+#include <Workload.hpp>
+#include <chrono>
+
+using namespace std;
+using namespace optp;
+
+template <typename F>
+static double nsPerToken(const size_t nToken, F &&f)
+{
+  auto start = chrono::steady_clock::now();
+
+  f();
+
+  return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() /
+         static_cast<double>(nToken);
+}
+
+// parse time per token for synthetic command lines of up to a million tokens
+int main(void)
+{
+  printf("%6s %8s %10s %10s %10s\n", "nOpt", "nToken", "parse", "parallel", "freeze");
+  for (unsigned int nOpt : {10u, 100u, 1000u})
+  {
+    for (size_t nToken = 1000; nToken <= 1000000; nToken *= 10)
+    {
+      Workload workload(nOpt * nToken, nOpt);
+      vector<string> args = workload.makeArgs(nToken);
+      auto argv = Workload::argv(args);
+      int argc = static_cast<int>(argv.size());
+      OptParser opt;
+      double parse, parallel, freeze;
+
+      workload.makeSchema(opt);
+      parse = nsPerToken(args.size(), [&]() { opt.parse(argc, argv.data()); });
+      parallel =
+          nsPerToken(args.size(), [&]() { opt.parseParallel(argc, argv.data()); });
+      freeze = nsPerToken(args.size(), [&]() { opt.freeze(); });
+      printf("%6u %8zu %10.1f %10.1f %10.1f\n", nOpt, args.size(), parse, parallel,
+             freeze);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+#include <OptParser.hpp>
+#include <chrono>
+#include <dirent.h>
+#include <fstream>
+
+using namespace std;
+using namespace optp;
+
+// Input layout: one control byte, then NUL-separated arguments. The low six
+// bits of the control byte scale the schema, bit 6 allows abbreviations and
+// bit 7 joins the arguments into a single command line.
+//
+// Each input is run as is and scaled by 4 in three directions: number of
+// arguments, length of each argument and number of options. Every part of
+// the parse is expected to be linear in these, so a time ratio far above 4
+// is reported as a crash. The ratios are wall-clock times, only meaningful in
+// a libFuzzer session: the standalone driver and the corpus replay registered
+// in ctest (which sets OPT_PARSER_FUZZ_NO_TIMING) only run each input.
+
+static const unsigned int scale = 4;
+static const double maxRatio = 12.;
+static const double minTime = 2e-3;
+
+struct Input
+{
+  unsigned int nOpt;
+  bool abbrev, cmdline;
+  vector<string> arg;
+};
+
+static string name(unsigned int i)
+{
+  string s;
+
+  do
+  {
+    s += static_cast<char>('a' + i % 26);
+    i /= 26;
+  } while (i > 0);
+
+  return s;
+}
+
+static void makeSchema(OptParser &opt, const Input &in)
+{
+  opt.addOption("v", "verbose", OptParser::OptType::trigger, true, "verbose");
+  opt.addOption("n", "number", OptParser::OptType::value, true, "number", "0");
+  opt.addChoice("c", "colour", {"red", "green", "blue"}, true, "colour", "red");
+  // long shared prefixes for the trie and the abbreviation lookup
+  for (unsigned int i = 0; i < in.nOpt; ++i)
+  {
+    opt.addOption("", "option-" + name(i), OptParser::OptType::value, true, "");
+  }
+  opt.allowAbbreviation(in.abbrev);
+}
+
+static void run(const Input &in)
+{
+  OptParser opt;
+  vector<const char *> argv = {"fuzz"};
+  double d;
+  long l;
+  int i;
+  unsigned int u;
+
+  makeSchema(opt, in);
+  if (in.cmdline)
+  {
+    string cmdline;
+
+    for (auto &a : in.arg)
+    {
+      cmdline += a + " ";
+    }
+    opt.parse(cmdline);
+  }
+  else
+  {
+    for (auto &a : in.arg)
+    {
+      argv.push_back(a.c_str());
+    }
+    opt.parse(static_cast<int>(argv.size()), argv.data());
+  }
+  for (auto &a : in.arg)
+  {
+    tryStrTo(a, d);
+    tryStrTo(a, l);
+    tryStrTo(a, i);
+    tryStrTo(a, u);
+    strTo<double>(a);
+    strTo<long>(a);
+  }
+}
+
+// best of three, to keep scheduling noise out of the ratios
+static double time(const Input &in)
+{
+  double best = 0.;
+
+  for (unsigned int k = 0; k < 3; ++k)
+  {
+    auto start = chrono::steady_clock::now();
+
+    run(in);
+
+    double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    best = (k == 0) ? t : min(best, t);
+  }
+
+  return best;
+}
+
+// a suspicious ratio is measured again before being reported, a single slow
+// run is more likely a preemption than a super-linear path
+static void check(const char *what, const Input &in, const Input &scaled)
+{
+  double t = 0., tScaled = 0.;
+
+  for (unsigned int k = 0; k < 3; ++k)
+  {
+    t = time(in);
+    tScaled = time(scaled);
+    if ((tScaled <= minTime) or (tScaled <= maxRatio * t))
+    {
+      return;
+    }
+  }
+  fprintf(stderr, "super-linear %s: %.3g s -> %.3g s for %ux\n", what, t, tScaled,
+          scale);
+  abort();
+}
+
+static bool timingEnabled(void)
+{
+#ifdef OPT_PARSER_FUZZ_MAIN
+  return false;
+#else
+  return getenv("OPT_PARSER_FUZZ_NO_TIMING") == nullptr;
+#endif
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  Input in, scaled;
+  streambuf *cerrBuf;
+  ostringstream sink;
+
+  if (size == 0)
+  {
+    return 0;
+  }
+  in.nOpt = 8 + (data[0] & 63u) * 16;
+  in.abbrev = data[0] & 64u;
+  in.cmdline = data[0] & 128u;
+  in.arg.emplace_back();
+  for (size_t i = 1; i < size; ++i)
+  {
+    if (data[i] == '\0')
+    {
+      in.arg.emplace_back();
+    }
+    else
+    {
+      in.arg.back() += static_cast<char>(data[i]);
+    }
+  }
+  // parse warnings would dominate the timings
+  cerrBuf = cerr.rdbuf(sink.rdbuf());
+  if (!timingEnabled())
+  {
+    run(in);
+    cerr.rdbuf(cerrBuf);
+
+    return 0;
+  }
+  scaled = in;
+  for (unsigned int k = 1; k < scale; ++k)
+  {
+    scaled.arg.insert(scaled.arg.end(), in.arg.begin(), in.arg.end());
+  }
+  check("in the number of arguments", in, scaled);
+  scaled = in;
+  for (auto &a : scaled.arg)
+  {
+    string r;
+
+    for (unsigned int k = 0; k < scale; ++k)
+    {
+      r += a;
+    }
+    a = r;
+  }
+  check("in the argument length", in, scaled);
+  scaled = in;
+  scaled.nOpt *= scale;
+  check("in the number of options", in, scaled);
+  cerr.rdbuf(cerrBuf);
+
+  return 0;
+}
+
+#ifdef OPT_PARSER_FUZZ_MAIN
+// standalone driver for AFL and offline runs: each argument is a file or a
+// directory of files, stdin without argument
+static void runFile(const string &path)
+{
+  ifstream file(path, ios::binary);
+  string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+  LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    string data((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  }
+  for (int i = 1; i < argc; ++i)
+  {
+    DIR *dir = opendir(argv[i]);
+
+    if (dir)
+    {
+      while (struct dirent *entry = readdir(dir))
+      {
+        if (entry->d_name[0] != '.')
+        {
+          runFile(string(argv[i]) + "/" + entry->d_name);
+        }
+      }
+      closedir(dir);
+    }
+    else
+    {
+      runFile(argv[i]);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,96 @@
+/*
+ * TestUtils.hpp, part of OptParser
+ *
+ * Copyright (C) 2022-2023 Antonin Portelli
+ *
+ * OptParser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OptParser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OptParser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TestUtils_hpp_
+#define TestUtils_hpp_
+
+#include <OptParser.hpp>
+
+// prints the message of a failed check and returns false
+inline bool fail(const std::string &msg)
+{
+  std::cerr << msg << std::endl;
+
+  return false;
+}
+
+// schema shared by the tests: a mandatory value, a trigger and a choice
+inline void makeSchema(optp::OptParser &opt)
+{
+  opt.addOption("a", "long-a", optp::OptParser::OptType::value, false, "option a");
+  opt.addOption("b", "long-b", optp::OptParser::OptType::trigger, true, "option b");
+  opt.addChoice("c", "", {"x", "y", "z"}, true, "option c", "x");
+}
+
+// redirects cerr to a string while it lives
+class CerrCapture
+{
+public:
+  CerrCapture(void) : buf_(std::cerr.rdbuf(out_.rdbuf())) {}
+  ~CerrCapture(void) { std::cerr.rdbuf(buf_); }
+  std::string str(void) const { return out_.str(); }
+
+private:
+  std::ostringstream out_;
+  std::streambuf *buf_;
+};
+
+// compact text of a parse event, "O<opt>:<value>;" or "P:<argument>;"
+inline std::string eventString(const optp::ParseEvent::Type type, const unsigned int opt,
+                               const char *value, const std::size_t size)
+{
+  return ((type == optp::ParseEvent::Type::option) ? "O" + std::to_string(opt) : "P") +
+         ":" + (value ? std::string(value, size) : "<none>") + ";";
+}
+
+inline std::string eventString(const optp::ParseEvent &ev)
+{
+  return eventString(ev.type, ev.opt, ev.value, ev.size);
+}
+
+// visitor recording the callbacks with eventString
+class RecordVisitor : public optp::ParseVisitor
+{
+public:
+  virtual void option(const unsigned int opt, const char *value, const std::size_t size)
+  {
+    log += eventString(optp::ParseEvent::Type::option, opt, value, size);
+  }
+  virtual void positional(const char *arg, const std::size_t size)
+  {
+    log += eventString(optp::ParseEvent::Type::positional, 0, arg, size);
+  }
+
+public:
+  std::string log;
+};
+
+// parse with the warnings written to cerr returned in warning
+inline bool parseCapture(optp::OptParser &opt, const int argc, const char *argv[],
+                         std::string &warning)
+{
+  CerrCapture capture;
+  bool isCorrect = opt.parse(argc, argv);
+
+  warning = capture.str();
+
+  return isCorrect;
+}
+
+#endif // TestUtils_hpp_
@@ -0,0 +1,140 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+static bool run(OptParser &opt, vector<const char *> argv, string &warning)
+{
+  ostringstream buf;
+  streambuf *cerrBuf = cerr.rdbuf(buf.rdbuf());
+  bool isCorrect;
+
+  argv.insert(argv.begin(), "abbreviation");
+  isCorrect = opt.parse(static_cast<int>(argv.size()), argv.data());
+  cerr.rdbuf(cerrBuf);
+  warning = buf.str();
+
+  return isCorrect;
+}
+
+// exact names win over longer names they prefix, unique prefixes resolve,
+// ambiguous ones list their candidates, and options added after a parse are
+// seen by the next one
+static bool testPrefix(void)
+{
+  OptParser opt;
+  string warning;
+
+  opt.addOption("", "verbose", OptParser::OptType::trigger, true);
+  opt.addOption("", "verbosity", OptParser::OptType::value, true);
+  opt.addOption("", "version", OptParser::OptType::trigger, true);
+  opt.addOption("", "output", OptParser::OptType::value, true);
+  opt.allowAbbreviation();
+  if (!run(opt, {"--verbose", "--out", "x"}, warning) or !warning.empty() or
+      !opt.gotOption("verbose") or opt.gotOption("verbosity") or
+      (opt.optionValue("output") != "x"))
+  {
+    return fail("exact match or unique prefix not resolved: " + warning);
+  }
+  if (!run(opt, {"--verbosi=2"}, warning) or (opt.optionValue("verbosity") != "2"))
+  {
+    return fail("unique prefix through a split edge not resolved: " + warning);
+  }
+  if (run(opt, {"--ver"}, warning) or
+      (warning.find("ambiguous option '--ver', could be --verbose, --verbosity, "
+                    "--version") == string::npos))
+  {
+    return fail("ambiguous prefix, unexpected warning: " + warning);
+  }
+  if (run(opt, {"--verb"}, warning) or
+      (warning.find("could be --verbose, --verbosity\n") == string::npos))
+  {
+    return fail("ambiguous prefix below a split, unexpected warning: " + warning);
+  }
+  opt.addOption("", "outfile", OptParser::OptType::value, true);
+  if (run(opt, {"--out", "x"}, warning) or
+      (warning.find("could be --outfile, --output") == string::npos))
+  {
+    return fail("option added after parse not indexed: " + warning);
+  }
+  if (!run(opt, {"--outf", "y"}, warning) or (opt.optionValue("outfile") != "y"))
+  {
+    return fail("prefix of option added after parse not resolved: " + warning);
+  }
+  opt.allowAbbreviation(false);
+  if (!run(opt, {"--outp", "y"}, warning) or opt.gotOption("output") or
+      (warning.find("unknown option '--outp'") == string::npos))
+  {
+    return fail("prefix accepted without abbreviations: " + warning);
+  }
+
+  return true;
+}
+
+// nearest long names, all of them on ties, none when too far
+static bool testSuggest(void)
+{
+  OptParser opt;
+  string warning;
+
+  opt.addOption("a", "alpha", OptParser::OptType::trigger, true);
+  opt.addOption("", "alpho", OptParser::OptType::trigger, true);
+  opt.addOption("c", "colour", OptParser::OptType::value, true);
+  opt.addOption("x", "", OptParser::OptType::trigger, true);
+  if (opt.suggest("color") != vector<string>{"--colour"})
+  {
+    return fail("suggest(color) is not --colour");
+  }
+  if (opt.suggest("alphx") != vector<string>({"--alpha", "--alpho"}))
+  {
+    return fail("suggest(alphx) is not --alpha, --alpho");
+  }
+  if (!opt.suggest("zzzzzz").empty() or !opt.suggest("x").empty())
+  {
+    return fail("suggestion for a distant or short-only name");
+  }
+  run(opt, {"--colur=red"}, warning);
+  if (warning != "warning: unknown option '--colur=red', did you mean --colour?\n")
+  {
+    return fail("unexpected unknown option warning: " + warning);
+  }
+
+  return true;
+}
+
+// access by name goes through the same trie as the parse, an option added after
+// a parse can be accessed, and a name used as short and long name gives the
+// first option
+static bool testName(void)
+{
+  OptParser opt;
+  string warning;
+
+  opt.addOption("x", "", OptParser::OptType::trigger, true);
+  opt.addOption("", "x", OptParser::OptType::value, true, "", "long");
+  opt.addOption("a", "alpha", OptParser::OptType::value, true, "", "1");
+  run(opt, {"--alpha", "2"}, warning);
+  opt.addOption("b", "beta", OptParser::OptType::value, true, "", "3");
+  run(opt, {"-x", "-b", "4"}, warning);
+  if (!opt.gotOption("x") or (opt.optionValue<int>("a") != 1) or
+      (opt.optionValue<int>("alpha") != 1) or (opt.optionValue<int>("beta") != 4) or
+      (opt.optionValue<int>("b") != 4))
+  {
+    return fail("unexpected access by name");
+  }
+  try
+  {
+    opt.gotOption("alp");
+  }
+  catch (out_of_range &)
+  {
+    return true;
+  }
+
+  return fail("access by an abbreviated name");
+}
+
+int main(void)
+{
+  return (testPrefix() and testSuggest() and testName()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,88 @@
+#include <OptParser.hpp>
+
+using namespace std;
+using namespace optp;
+
+static void makeArgvSchema(OptParser &opt)
+{
+  opt.addOption("a", "alpha", OptParser::OptType::value, true, "with default", "def");
+  opt.addOption("s", "", OptParser::OptType::value, true, "short-only value");
+  opt.addOption("t", "", OptParser::OptType::trigger, true, "short-only trigger");
+  opt.addOption("", "text", OptParser::OptType::value, true, "free text");
+  opt.addOption("", "flag", OptParser::OptType::trigger, true, "long-only trigger");
+}
+
+// canonical configuration, with the presence of options unless defaults are
+// omitted
+static string state(const OptParser &opt, const bool omitDefaults)
+{
+  string res = opt.canonicalConfig();
+
+  for (auto name : {"alpha", "s", "t", "text", "flag"})
+  {
+    res += omitDefaults ? "" : (opt.gotOption(name) ? "1" : "0");
+  }
+
+  return res;
+}
+
+// rebuilding argv from a parse and parsing it again, directly or through its
+// shell-quoted string, gives back the same result
+static bool check(vector<const char *> arg, const bool omitDefaults)
+{
+  OptParser opt, fromArgv, fromStr;
+  Argv argv, split;
+
+  makeArgvSchema(opt);
+  makeArgvSchema(fromArgv);
+  makeArgvSchema(fromStr);
+  arg.insert(arg.begin(), "build-argv");
+  if (!opt.parse(static_cast<int>(arg.size()), arg.data()))
+  {
+    cerr << "parse failed for '" << arg[1] << "'" << endl;
+
+    return false;
+  }
+  argv = opt.buildArgv("build-argv", omitDefaults);
+  fromArgv.parse(argv.argc(), const_cast<const char **>(argv.argv()));
+  split = OptParser::splitCommandLine(argv.str());
+  fromStr.parse(split.argc(), const_cast<const char **>(split.argv()));
+  if ((state(fromArgv, omitDefaults) != state(opt, omitDefaults)) or
+      (state(fromStr, omitDefaults) != state(opt, omitDefaults)))
+  {
+    cerr << "round trip changed the result of '" << arg[1] << "', rebuilt as:" << endl;
+    cerr << argv.str() << endl;
+
+    return false;
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  bool ok = true;
+
+  ok = check({"--alpha=x", "-s", "v", "-t", "--flag", "pos"}, false) and ok;
+  ok = check({"--text", "", "-s", "", "pos", ""}, false) and ok;
+  ok = check({"--text", "line 1\nline 2", "-s", "a\nb", "pos\nline"}, false) and ok;
+  ok = check({"-sshort", "--text=it's \"quoted\" $HOME \\", "a b"}, false) and ok;
+  ok = check({"--text==x", "-s=y", "--", "-t"}, false) and ok;
+  ok = check({"--alpha=def", "-t"}, true) and ok;
+  ok = check({"--alpha=other", "--text=def"}, true) and ok;
+  // default values are dropped with omitDefaults
+  {
+    OptParser opt;
+    const char *argv[] = {"build-argv", "--alpha", "def", "-t"};
+
+    makeArgvSchema(opt);
+    opt.parse(4, argv);
+    if (opt.buildArgv("p", true).str() != "p -t")
+    {
+      cerr << "default not omitted: " << opt.buildArgv("p", true).str() << endl;
+      ok = false;
+    }
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
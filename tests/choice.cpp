@@ -0,0 +1,91 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+enum class Colour
+{
+  red,
+  green,
+  blue
+};
+
+static void makeChoiceSchema(OptParser &opt)
+{
+  opt.addChoice("c", "colour", {"red", "green", "blue"}, true, "colour", "green");
+  opt.addChoice("s", "", {"one", "two"}, true, "short-only choice");
+}
+
+// message of the logic_error thrown by addChoice, empty if none
+static string addChoiceError(const string shortName, const string longName,
+                             const vector<string> choice, const string defaultVal = "")
+{
+  OptParser opt;
+
+  try
+  {
+    opt.addChoice(shortName, longName, choice, true, "", defaultVal);
+  }
+  catch (logic_error &e)
+  {
+    return e.what();
+  }
+
+  return "";
+}
+
+// values are checked against the choice list and map to an enumeration declared
+// in the same order
+int main(void)
+{
+  bool ok = true;
+
+  // valid values, and the default
+  {
+    OptParser opt;
+    const char *argv[] = {"choice", "-s", "two"};
+    string warning;
+
+    makeChoiceSchema(opt);
+    ok &= parseCapture(opt, 3, argv, warning) or fail("valid choices rejected");
+    ok &= (opt.optionChoice<Colour>("colour") == Colour::green) or
+          fail("default choice not mapped to Colour::green");
+    ok &= (opt.optionChoice<int>("s") == 1) or fail("choice 'two' not mapped to 1");
+    ok &= (opt.freeze().optionChoice<Colour>("colour") == Colour::green) or
+          fail("frozen choice not mapped to Colour::green");
+    ok &= warning.empty() or fail("unexpected warning " + warning);
+  }
+  {
+    OptParser opt;
+    const char *argv[] = {"choice", "--colour=blue"};
+
+    makeChoiceSchema(opt);
+    ok &= (opt.parse(2, argv) and (opt.optionChoice<Colour>("c") == Colour::blue)) or
+          fail("choice 'blue' not mapped to Colour::blue");
+  }
+
+  // invalid value
+  {
+    OptParser opt;
+    const char *argv[] = {"choice", "--colour", "purple"};
+    string expected = "warning: invalid value 'purple' for option -c/--colour=, "
+                      "expected one of red, green, blue\n";
+    string warning;
+
+    makeChoiceSchema(opt);
+    ok &= !parseCapture(opt, 3, argv, warning) or fail("invalid choice accepted");
+    ok &= (warning == expected) or fail("unexpected warning " + warning);
+  }
+
+  // schema errors name the option by its long name, or its short one
+  ok &= (addChoiceError("c", "colour", {}) == "empty choice list for option 'colour'") or
+        fail("unexpected error for an empty list");
+  ok &= (addChoiceError("s", "", {"one", "two", "one"}) ==
+         "duplicate choice 'one' for option 's'") or
+        fail("unexpected error for a duplicate choice");
+  ok &= (addChoiceError("c", "colour", {"red"}, "blue") ==
+         "default value 'blue' is not a choice for option 'colour'") or
+        fail("unexpected error for an invalid default");
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
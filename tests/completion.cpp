@@ -0,0 +1,107 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+static void makeCompletionSchema(OptParser &opt)
+{
+  opt.addOption("a", "alpha", OptParser::OptType::value, true, "alpha value");
+  opt.addOption("b", "beta", OptParser::OptType::trigger, true, "beta trigger");
+  opt.addChoice("", "colour", {"red", "green", "blue"}, true, "colour");
+  opt.addOption("", "count", OptParser::OptType::value, true, "count");
+}
+
+// answer of the protocol for "prog --complete <cword> <words...>"
+static string complete(OptParser &opt, const vector<const char *> &word)
+{
+  vector<const char *> argv = {"prog", "--complete"};
+  ostringstream out;
+
+  argv.insert(argv.end(), word.begin(), word.end());
+  if (!opt.complete(static_cast<int>(argv.size()), argv.data(), out))
+  {
+    return "not a completion request";
+  }
+
+  return out.str();
+}
+
+// exact answers of the completion protocol, and the generated scripts
+int main(void)
+{
+  struct Case
+  {
+    string what;
+    vector<const char *> word;
+    string expected;
+  };
+  const vector<Case> test = {
+      {"empty prefix", {"1", "prog", ""}, ""},
+      {"short prefix",
+       {"1", "prog", "-"},
+       "--alpha\n--beta\n--colour\n--count\n-a\n-b\n"},
+      {"short name", {"1", "prog", "-b"}, "-b\n"},
+      {"long prefix", {"1", "prog", "--c"}, "--colour\n--count\n"},
+      {"inline value",
+       {"1", "prog", "--colour="},
+       "--colour=red\n--colour=green\n--colour=blue\n"},
+      {"inline value prefix", {"1", "prog", "--colour=g"}, "--colour=green\n"},
+      {"bash split on '='", {"2", "prog", "--colour", "="}, "red\ngreen\nblue\n"},
+      {"bash split on '=' with prefix", {"3", "prog", "--colour", "=", "b"}, "blue\n"},
+      {"separate value", {"2", "prog", "--colour", "r"}, "red\n"},
+      {"value without choices", {"2", "prog", "-a", ""}, ""},
+      {"unknown prefix", {"1", "prog", "--zz"}, ""},
+      {"unknown option value", {"1", "prog", "--zz=a"}, ""}};
+  bool ok = true;
+
+  for (auto &c : test)
+  {
+    OptParser opt;
+    string answer;
+
+    makeCompletionSchema(opt);
+    answer = complete(opt, c.word);
+    ok &= (answer == c.expected) or fail(c.what + ": unexpected answer\n" + answer);
+  }
+  {
+    OptParser opt;
+    const char *argv[] = {"prog", "-a", "1"};
+
+    makeCompletionSchema(opt);
+    ok &= !opt.complete(3, argv, cerr) or
+          fail("normal command line taken for completion");
+  }
+
+  // the scripts register the program and list the names the protocol gives
+  {
+    OptParser opt;
+    ostringstream bash, zsh;
+
+    makeCompletionSchema(opt);
+    opt.writeCompletion(bash, "my-prog", OptParser::Shell::bash);
+    opt.writeCompletion(zsh, "my-prog", OptParser::Shell::zsh);
+    ok &= (bash.str().find("complete -o default -F _my_prog_complete my-prog\n") !=
+           string::npos) or
+          fail("bash script does not register my-prog\n" + bash.str());
+    ok &= (bash.str().find("compgen -W \"-a --alpha -b --beta --colour --count\"") !=
+           string::npos) or
+          fail("bash script does not list the option names\n" + bash.str());
+    ok &= (bash.str().find("--colour) COMPREPLY=($(compgen -W \"red green blue\"") !=
+           string::npos) or
+          fail("bash script does not complete choices\n" + bash.str());
+    ok &= (bash.str().find("-a|--alpha|--count) return 0;;") != string::npos) or
+          fail("bash script does not complete plain values as files\n" + bash.str());
+    ok &= (zsh.str().compare(0, 17, "#compdef my-prog\n") == 0) or
+          fail("zsh script does not register my-prog\n" + zsh.str());
+    for (auto &spec : {"{-a+,--alpha=}'[alpha value]:value:_files'",
+                       "{-b,--beta}'[beta trigger]'",
+                       "'--colour=[colour]:value:(red green blue)'",
+                       "'--count=[count]:value:_files'"})
+    {
+      ok &= (zsh.str().find(spec) != string::npos) or
+            fail("zsh script misses " + string(spec) + "\n" + zsh.str());
+    }
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
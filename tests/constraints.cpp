@@ -0,0 +1,91 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+static void makeConstraintSchema(OptParser &opt)
+{
+  opt.addOption("i", "input", OptParser::OptType::value, true, "input file");
+  opt.addOption("o", "output", OptParser::OptType::value, true, "output file");
+  opt.addOption("f", "format", OptParser::OptType::value, true, "output format", "txt");
+  opt.addOption("v", "verbose", OptParser::OptType::trigger, true, "verbose");
+  opt.addOption("q", "quiet", OptParser::OptType::trigger, true, "quiet");
+  opt.addOption("", "json", OptParser::OptType::trigger, true, "JSON output");
+  opt.addOption("", "yaml", OptParser::OptType::trigger, true, "YAML output");
+  opt.addDependency("output", {"input", "format"});
+  opt.addConflict({"verbose", "quiet"});
+  opt.addExactlyOne({"json", "yaml"});
+}
+
+// each constraint met and violated; options left out count as absent, even
+// with a default value
+int main(void)
+{
+  struct Case
+  {
+    vector<const char *> arg;
+    bool isCorrect;
+    string warning;
+  };
+  const vector<Case> test = {
+      {{"--json"}, true, ""},
+      {{"--yaml", "-o", "out", "-i", "in", "-f", "csv", "-v"}, true, ""},
+      {{"--json", "-o", "out", "-i", "in"},
+       false,
+       "warning: option -o/--output= requires -f/--format=\n"},
+      {{"--json", "-o", "out"},
+       false,
+       "warning: option -o/--output= requires -i/--input=, -f/--format=\n"},
+      {{"--json", "-i", "in", "-f", "csv"}, true, ""},
+      {{"--json", "-q"}, true, ""},
+      {{"--json", "-q", "--verbose"},
+       false,
+       "warning: options -v/--verbose, -q/--quiet are mutually exclusive\n"},
+      {{},
+       false,
+       "warning: exactly one of the options --json, --yaml is required\n"},
+      {{"--json", "--yaml", "-v", "-q"},
+       false,
+       "warning: options -v/--verbose, -q/--quiet are mutually exclusive\n"
+       "warning: exactly one of the options --json, --yaml is required\n"}};
+  bool ok = true;
+
+  for (auto &c : test)
+  {
+    OptParser opt;
+    vector<const char *> argv = {"constraints"};
+    string warning, cmdline;
+    bool isCorrect;
+
+    argv.insert(argv.end(), c.arg.begin(), c.arg.end());
+    for (auto a : c.arg)
+    {
+      cmdline += string(" ") + a;
+    }
+    makeConstraintSchema(opt);
+    isCorrect = parseCapture(opt, static_cast<int>(argv.size()), argv.data(), warning);
+    ok &= (isCorrect == c.isCorrect) or
+          fail("'" + cmdline + "': parse returned " + strFrom(isCorrect));
+    ok &= (warning == c.warning) or
+          fail("'" + cmdline + "': unexpected warnings\n" + warning);
+  }
+
+  // constraints on unknown options are schema errors
+  {
+    OptParser opt;
+    bool thrown = false;
+
+    makeConstraintSchema(opt);
+    try
+    {
+      opt.addConflict({"verbose", "loud"});
+    }
+    catch (out_of_range &)
+    {
+      thrown = true;
+    }
+    ok &= thrown or fail("constraint on an unknown option accepted");
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
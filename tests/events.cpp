@@ -0,0 +1,93 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+// no choices, validators or mandatory options, so that the visitor parse only
+// warns about what the pull parser sees
+static void makeEventSchema(OptParser &opt)
+{
+  opt.addOption("a", "alpha", OptParser::OptType::value, true, "value");
+  opt.addOption("b", "beta", OptParser::OptType::trigger, true, "trigger");
+  opt.addOption("", "beta-two", OptParser::OptType::trigger, true, "trigger");
+  opt.allowAbbreviation();
+}
+
+// events and warnings of the first maxEvent events read from events()
+static bool pull(OptParser &opt, vector<const char *> argv, string &log,
+                 string &warning, const size_t maxEvent = string::npos)
+{
+  CerrCapture capture;
+  auto reader = opt.events(static_cast<int>(argv.size()), argv.data());
+  ParseEvent ev;
+  size_t n = 0;
+
+  log.clear();
+  while ((n < maxEvent) and reader.next(ev))
+  {
+    log += eventString(ev);
+    ++n;
+  }
+  warning = capture.str();
+
+  return reader.isCorrect();
+}
+
+// the pull parser gives the same events and warnings as a visitor parse,
+// including when it is dropped before the end of the command line
+int main(void)
+{
+  const vector<vector<const char *>> cmdline = {
+      {"pull"},
+      {"pull", "-a", "1", "pos", "-b", "--alpha=x y", "--beta-two", "", "-a2"},
+      {"pull", "--unknown", "-ab", "--bet", "pos", "-z", "-a"},
+      {"pull", "-a", "-b", "--alpha", "--al=v", "--alpha"}};
+  bool ok = true;
+
+  for (auto argv : cmdline)
+  {
+    OptParser opt;
+    RecordVisitor visitor;
+    string log, warning, visitWarning, name;
+    size_t nEvent;
+    bool isCorrect, visitCorrect;
+
+    for (auto a : argv)
+    {
+      name += string(name.empty() ? "" : " ") + "'" + a + "'";
+    }
+    makeEventSchema(opt);
+    {
+      CerrCapture capture;
+
+      visitCorrect = opt.parse(static_cast<int>(argv.size()), argv.data(), visitor);
+      visitWarning = capture.str();
+    }
+    nEvent = static_cast<size_t>(count(visitor.log.begin(), visitor.log.end(), ';'));
+    isCorrect = pull(opt, argv, log, warning);
+    ok &= (log == visitor.log) or
+          fail(name + ": events " + log + " differ from " + visitor.log);
+    ok &= (isCorrect == visitCorrect) or fail(name + ": different correctness");
+    ok &= (warning == visitWarning) or
+          fail(name + ": warnings\n" + warning + "differ from\n" + visitWarning);
+
+    // stop after each event: the events read so far and their warnings are a
+    // prefix of the full parse, and the next reader starts over
+    for (size_t k = 0; k <= nEvent; ++k)
+    {
+      string partLog, partWarning;
+
+      pull(opt, argv, partLog, partWarning, k);
+      ok &= ((visitor.log.compare(0, partLog.size(), partLog) == 0) and
+             (static_cast<size_t>(count(partLog.begin(), partLog.end(), ';')) == k) and
+             (visitWarning.compare(0, partWarning.size(), partWarning) == 0)) or
+            fail(name + ": unexpected events " + partLog + " after stopping at " +
+                 strFrom(k));
+      pull(opt, argv, log, warning);
+      ok &= (log == visitor.log) or
+            fail(name + ": events " + log + " differ after a stopped reader");
+    }
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
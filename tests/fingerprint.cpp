@@ -0,0 +1,130 @@
+#include "TestUtils.hpp"
+#include <tuple>
+
+using namespace std;
+using namespace optp;
+
+static void makeFingerprintSchema(OptParser &opt)
+{
+  opt.addOption("", "tag", OptParser::OptType::value, true, "free string");
+  opt.addOption("n", "num", OptParser::OptType::value, true, "declared number");
+  opt.addOption("", "count", OptParser::OptType::value, true, "validated integer");
+  opt.addOption("x", "", OptParser::OptType::trigger, true, "short-only x");
+  opt.addOption("", "x", OptParser::OptType::trigger, true, "long-only x");
+  opt.addOption("v", "verbose", OptParser::OptType::trigger, true, "verbosity");
+  opt.declareNumeric("num");
+  opt.addValidator<int>("count", inRange(-100, 100));
+}
+
+static Hash128 fingerprint(vector<const char *> arg, const bool exclude = true)
+{
+  OptParser opt;
+
+  makeFingerprintSchema(opt);
+  if (exclude)
+  {
+    opt.excludeFromFingerprint("verbose");
+  }
+  arg.insert(arg.begin(), "fingerprint");
+  opt.parse(static_cast<int>(arg.size()), arg.data());
+
+  return opt.fingerprint();
+}
+
+// MurmurHash3 x64_128 reference vectors, as printed by mmh3
+static bool testHash(void)
+{
+  const vector<tuple<string, uint64_t, string>> vec = {
+      make_tuple("", 0, "00000000000000000000000000000000"),
+      make_tuple("hello", 0, "029bbd41b3a7d8cb191dae486a901e5b"),
+      make_tuple("The quick brown fox jumps over the lazy dog", 0,
+                 "6c1b07bc7bbc4be347939ac4a93c437a"),
+      make_tuple("0123456789abcdef", 0, "a7d14acf946de04bda08a7635c5bc387"),
+      make_tuple("0123456789abcdefg", 42, "7ccb07f7054114d7dba7172f8db28149"),
+      make_tuple("optparser", 1, "106a3e7230acd974ddfb72943abd52ad")};
+
+  for (auto &v : vec)
+  {
+    const string &s = get<0>(v);
+    string h = hash128(s.data(), s.size(), get<1>(v)).hex();
+
+    if (h != get<2>(v))
+    {
+      return fail("hash128('" + s + "') = " + h + ", expected " + get<2>(v));
+    }
+  }
+
+  return true;
+}
+
+// different values give different fingerprints unless the option is numeric
+static bool testNormalise(void)
+{
+  typedef vector<const char *> Args;
+  const vector<pair<Args, Args>> same = {{{"--num=007"}, {"--num=7"}},
+                                         {{"--num=1.50"}, {"-n", "1.5"}},
+                                         {{"--num=1e3"}, {"--num=1000"}},
+                                         {{"--count=+3"}, {"--count=3"}},
+                                         {{"--tag=a", "-v"}, {"--tag=a"}}};
+  const vector<pair<Args, Args>> different = {
+      {{"--tag=1.10"}, {"--tag=1.1"}}, {{"--tag=007"}, {"--tag=7"}},
+      {{"--num=0x10"}, {"--num=16"}},  {{"--num=NaN"}, {"--num=nan"}},
+      {{"--num=inf"}, {"--num=INF"}},  {{"-x"}, {"--x"}}};
+
+  for (auto &p : same)
+  {
+    if (fingerprint(p.first) != fingerprint(p.second))
+    {
+      return fail(string("different fingerprints for ") + p.first[0]);
+    }
+  }
+  for (auto &p : different)
+  {
+    if (fingerprint(p.first) == fingerprint(p.second))
+    {
+      return fail(string("same fingerprint for ") + p.first[0]);
+    }
+  }
+  if (fingerprint({"-v"}, false) == fingerprint({}, false))
+  {
+    return fail("fingerprint ignores an option not excluded");
+  }
+
+  return true;
+}
+
+// excluding an option from the fingerprint does not change the schema
+static bool testSchema(void)
+{
+  OptParser master, worker;
+  const char *argv[] = {"fingerprint", "-v", "--num=3"};
+
+  makeFingerprintSchema(master);
+  makeFingerprintSchema(worker);
+  master.excludeFromFingerprint("verbose");
+  master.parse(3, argv);
+  try
+  {
+    worker.restore(FrozenResult::deserialize(master.freeze().serialize()));
+  }
+  catch (runtime_error &e)
+  {
+    return fail(string("restore failed: ") + e.what());
+  }
+  if (!worker.gotOption("verbose") or (worker.optionValue<int>("num") != 3))
+  {
+    return fail("unexpected restored result");
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  bool ok = testHash();
+
+  ok = testNormalise() and ok;
+  ok = testSchema() and ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
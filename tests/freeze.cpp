@@ -0,0 +1,67 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+// the call must throw E
+template <typename E, typename F>
+static bool throws(F &&f)
+{
+  try
+  {
+    f();
+  }
+  catch (E &)
+  {
+    return true;
+  }
+
+  return false;
+}
+
+// accessors of a frozen result, including the rejected ones
+static bool test(void)
+{
+  OptParser opt;
+  const char *argv[] = {"freeze", "-a", "12", "-cz", "pos"};
+  FrozenResult res, empty;
+
+  opt.addOption("a", "long-a", OptParser::OptType::value, false, "option a");
+  opt.addOption("b", "long-b", OptParser::OptType::trigger, true, "option b");
+  opt.addChoice("c", "", {"x", "y", "z"}, true, "option c", "x");
+  if (!opt.parse(5, argv))
+  {
+    return fail("parse failed");
+  }
+  res = opt.freeze();
+  if ((res.optionCount() != 3) or !res.gotOption(0u) or res.gotOption("long-b") or
+      (res.optionValue<int>("a") != 12) or (res.optionChoice("c") != 2) or
+      (res.argCount() != 1) or (string(res.arg(0)) != "pos"))
+  {
+    return fail("unexpected frozen result");
+  }
+  // out of range indices and names
+  if (!throws<out_of_range>([&]() { res.gotOption(3u); }) or
+      !throws<out_of_range>([&]() { res.optionValue(3u); }) or
+      !throws<out_of_range>([&]() { res.optionChoice(7u); }) or
+      !throws<out_of_range>([&]() { res.arg(1); }) or
+      !throws<out_of_range>([&]() { res.gotOption("d"); }))
+  {
+    return fail("out of range access not rejected");
+  }
+  // default-constructed result
+  if ((empty.optionCount() != 0) or (empty.argCount() != 0) or
+      !empty.getArgs().empty() or
+      !throws<runtime_error>([&]() { empty.gotOption(0u); }) or
+      !throws<runtime_error>([&]() { empty.optionSize(0u); }) or
+      !throws<runtime_error>([&]() { empty.argSize(0); }) or
+      !throws<runtime_error>([&]() { empty.optionValue<int>("a"); }) or
+      !throws<runtime_error>([&]() { opt.restore(empty); }))
+  {
+    return fail("empty result access not rejected");
+  }
+
+  return true;
+}
+
+int main(void) { return test() ? EXIT_SUCCESS : EXIT_FAILURE; }
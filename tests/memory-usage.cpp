@@ -0,0 +1,77 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+static size_t fieldSum(const MemoryUsage &u)
+{
+  return u.object + u.names + u.help + u.defaults + u.values + u.positionals + u.index +
+         u.overhead;
+}
+
+// options with long names, help messages and defaults, out of the small
+// string buffers
+static void addOptions(OptParser &opt, const unsigned int begin, const unsigned int end)
+{
+  for (unsigned int i = begin; i < end; ++i)
+  {
+    string name = "option-number-" + string(i + 1, 'x');
+
+    opt.addOption("", name, OptParser::OptType::value, true,
+                  "help message of option " + name, "default value of " + name);
+  }
+}
+
+// the components add up to the total, grow with the schema and the arguments,
+// and a frozen result is smaller than the parser holding the same parse
+int main(void)
+{
+  OptParser opt;
+  vector<string> token;
+  vector<const char *> argv = {"memory-usage"};
+  MemoryUsage empty, schema, bigSchema, parsed, moreArgs, frozen;
+  string warning;
+  bool ok = true;
+
+  empty = opt.memoryUsage();
+  addOptions(opt, 0, 10);
+  schema = opt.memoryUsage();
+  addOptions(opt, 10, 50);
+  bigSchema = opt.memoryUsage();
+  for (unsigned int i = 0; i < 50; ++i)
+  {
+    token.push_back("positional argument number " + strFrom(i));
+  }
+  for (auto &t : token)
+  {
+    argv.push_back(t.c_str());
+  }
+  ok &= parseCapture(opt, 11, argv.data(), warning) or fail("parse failed\n" + warning);
+  parsed = opt.memoryUsage();
+  ok &= parseCapture(opt, static_cast<int>(argv.size()), argv.data(), warning) or
+        fail("parse failed\n" + warning);
+  moreArgs = opt.memoryUsage();
+
+  FrozenResult res = opt.freeze();
+
+  frozen = res.memoryUsage();
+  for (auto &u : {empty, schema, bigSchema, parsed, moreArgs, frozen})
+  {
+    ok &= (fieldSum(u) == u.total()) or fail("fields do not add up to the total");
+  }
+  ok &= ((schema.names > empty.names) and (schema.help > empty.help) and
+         (schema.defaults > empty.defaults) and (bigSchema.names > schema.names) and
+         (bigSchema.help > schema.help) and (bigSchema.total() > schema.total())) or
+        fail("usage does not grow with the schema");
+  ok &= ((parsed.positionals > bigSchema.positionals) and
+         (moreArgs.positionals > parsed.positionals) and
+         (moreArgs.total() > parsed.total())) or
+        fail("usage does not grow with the arguments");
+  ok &= ((frozen.positionals > 0) and (frozen.values > 0) and
+         (frozen.total() < moreArgs.total())) or
+        fail("frozen result (" + strFrom(frozen.total()) +
+             " bytes) not smaller than the parser (" + strFrom(moreArgs.total()) +
+             " bytes)");
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+#include "TestUtils.hpp"
+#include <random>
+
+using namespace std;
+using namespace optp;
+
+// shared schema, plus a long name extended from --long-b and a mandatory option
+static void makeParallelSchema(OptParser &opt)
+{
+  makeSchema(opt);
+  opt.addOption("", "long-bb", OptParser::OptType::trigger, true, "option bb");
+  opt.addOption("m", "", OptParser::OptType::value, false, "option m");
+  opt.allowAbbreviation();
+}
+
+struct Result
+{
+  bool isCorrect;
+  string config, warning;
+  vector<string> arg;
+};
+
+static Result run(const int argc, const char *argv[], const unsigned int nThread)
+{
+  OptParser opt;
+  ostringstream warning;
+  streambuf *cerrBuf = cerr.rdbuf(warning.rdbuf());
+  Result res;
+
+  makeParallelSchema(opt);
+  if (nThread == 0)
+  {
+    res.isCorrect = opt.parse(argc, argv);
+  }
+  else
+  {
+    res.isCorrect = opt.parseParallel(argc, argv, nThread);
+  }
+  cerr.rdbuf(cerrBuf);
+  res.config = opt.canonicalConfig();
+  res.warning = warning.str();
+  res.arg = opt.getArgs();
+
+  return res;
+}
+
+// random command lines mixing options, values, positional arguments and
+// errors, so that chunk boundaries fall on every kind of token; the parallel
+// parse must give the same result and warnings as the sequential one
+int main(void)
+{
+  const vector<string> word = {"-a",   "--long-a=1", "pos", "-b",  "--long-b", "--long",
+                               "-cy",  "-c",         "w",   "-m",  "--nope",   "-q",
+                               "-a12", "--long-a",   "",    "x y", "--long-bb"};
+  mt19937 rng(42);
+
+  for (unsigned int k = 0; k < 20; ++k)
+  {
+    const unsigned int n = 1 + rng() % 50000, nThread = 2 + k % 4;
+    vector<string> token;
+    vector<const char *> argv = {"parallel"};
+
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      token.push_back(word[rng() % word.size()]);
+    }
+    for (auto &t : token)
+    {
+      argv.push_back(t.c_str());
+    }
+
+    const int argc = static_cast<int>(argv.size());
+    Result seq = run(argc, argv.data(), 0), par = run(argc, argv.data(), nThread);
+
+    if ((seq.isCorrect != par.isCorrect) or (seq.config != par.config) or
+        (seq.warning != par.warning) or (seq.arg != par.arg))
+    {
+      cerr << "parallel parse of " << n << " tokens on " << nThread;
+      cerr << " threads differs from sequential parse" << endl;
+
+      return EXIT_FAILURE;
+    }
+  }
+
+  // bulk conversion of positional arguments, with an invalid one every 1000
+  {
+    OptParser opt;
+    vector<string> token;
+    vector<const char *> argv = {"parallel"};
+    vector<OptParser::ConversionError> seqError, parError;
+
+    for (unsigned int i = 0; i < 100000; ++i)
+    {
+      token.push_back(strFrom(i) + ((i % 1000 == 7) ? "x" : ""));
+    }
+    for (auto &t : token)
+    {
+      argv.push_back(t.c_str());
+    }
+    opt.parse(static_cast<int>(argv.size()), argv.data());
+
+    vector<long> seq = opt.getArgs<long>(seqError, 1);
+    vector<long> par = opt.getArgs<long>(parError, 4);
+
+    if ((seq != par) or (seqError.size() != 100) or (parError.size() != 100) or
+        (parError[99].index != 99007) or (par[99008] != 99008))
+    {
+      cerr << "parallel conversion of positional arguments failed" << endl;
+
+      return EXIT_FAILURE;
+    }
+  }
+
+  // unsigned conversions reject negative and out-of-range values
+  {
+    OptParser opt;
+    const char *argv[] = {"parallel",
+                          "1",
+                          "-1",
+                          " -3",
+                          "4294967296",
+                          "18446744073709551615",
+                          "18446744073709551616",
+                          "+5",
+                          "256",
+                          "65536"};
+    vector<OptParser::ConversionError> uError, sizeError, shortError, charError;
+    auto index = [](const vector<OptParser::ConversionError> &error)
+    {
+      vector<size_t> res;
+
+      for (auto &e : error)
+      {
+        res.push_back(e.index);
+      }
+
+      return res;
+    };
+
+    opt.parse(10, argv);
+
+    vector<unsigned int> u = opt.getArgs<unsigned int>(uError);
+    vector<size_t> size = opt.getArgs<size_t>(sizeError);
+    vector<unsigned short> us = opt.getArgs<unsigned short>(shortError);
+    vector<unsigned char> uc = opt.getArgs<unsigned char>(charError);
+
+    if ((index(uError) != vector<size_t>{1, 2, 3, 4, 5}) or (u[0] != 1) or
+        (u[6] != 5) or (index(sizeError) != vector<size_t>{1, 2, 5}) or
+        (size[4] != 18446744073709551615ull) or
+        (index(shortError) != vector<size_t>{1, 2, 3, 4, 5, 8}) or (us[7] != 256) or
+        (index(charError) != vector<size_t>{1, 2, 3, 4, 5, 7, 8}) or (uc[0] != 1) or
+        (uc[6] != 5))
+    {
+      cerr << "unsigned conversion of positional arguments failed" << endl;
+
+      return EXIT_FAILURE;
+    }
+  }
+
+  // statistics counters and hook, left untouched without OPT_PARSER_STATS
+  {
+    OptParser opt;
+    const char *argv[] = {"parallel", "-a", "1", "pos", "--nope", "-b", "--long-b", "-q"};
+    ostringstream warning;
+    streambuf *cerrBuf = cerr.rdbuf(warning.rdbuf());
+    vector<ParseStats> hookStats;
+    bool isCorrect = true;
+
+    makeParallelSchema(opt);
+    opt.setStatsHook([&hookStats](const ParseStats &stats)
+                     { hookStats.push_back(stats); });
+    opt.parse(8, argv);
+
+    ParseStats seq = opt.stats();
+
+    opt.parseParallel(8, argv, 3);
+    cerr.rdbuf(cerrBuf);
+
+    const ParseStats &par = opt.stats();
+
+#ifdef OPT_PARSER_STATS
+    isCorrect = (seq.token == 7) and (seq.lookup == 5) and (seq.unknown == 2) and
+                (par.token == seq.token) and (par.lookup == seq.lookup) and
+                (par.unknown == seq.unknown) and (hookStats.size() == 2) and
+                (hookStats[0].token == seq.token) and
+                (hookStats[0].parseTime == seq.parseTime) and
+                (hookStats[1].parseTime == par.parseTime) and (seq.parseTime > 0);
+#else
+    isCorrect = (seq.token == 0) and (seq.lookup == 0) and (par.token == 0) and
+                (par.parseTime == 0) and hookStats.empty();
+#endif
+    if (!isCorrect)
+    {
+      cerr << "unexpected parse statistics: " << seq.token << " tokens, ";
+      cerr << seq.lookup << " lookups, " << seq.unknown << " unknown, ";
+      cerr << hookStats.size() << " hook calls" << endl;
+
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
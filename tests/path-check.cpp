@@ -0,0 +1,132 @@
+#include <OptParser.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace optp;
+
+static void makePathSchema(OptParser &opt)
+{
+  opt.addOption("i", "in", OptParser::OptType::value, true, "input file");
+  opt.addOption("d", "dir", OptParser::OptType::value, true, "directory");
+  opt.addOption("o", "out", OptParser::OptType::value, true, "output file");
+  opt.addOption("l", "log", OptParser::OptType::value, true, "log file");
+  opt.addPathCheck("in", OptParser::pathExists | OptParser::pathIsFile);
+  opt.addPathCheck("dir", OptParser::pathIsDir);
+  opt.addPathCheck("out", OptParser::pathCreatable);
+  opt.addPathCheck("log", OptParser::pathWritable);
+  opt.addArgPathCheck(OptParser::pathExists);
+}
+
+// parses with paths relative to dir and compares the violations
+static bool check(const string &dir, const vector<string> &arg,
+                  const vector<string> &expected)
+{
+  OptParser opt;
+  vector<string> token;
+  vector<const char *> argv = {"path-check"};
+  ostringstream warning;
+  streambuf *cerrBuf = cerr.rdbuf(warning.rdbuf());
+  bool isCorrect;
+
+  makePathSchema(opt);
+  for (auto &a : arg)
+  {
+    token.push_back((a[0] == '-') ? a : dir + "/" + a);
+  }
+  for (auto &t : token)
+  {
+    argv.push_back(t.c_str());
+  }
+  isCorrect = opt.parse(static_cast<int>(argv.size()), argv.data());
+  cerr.rdbuf(cerrBuf);
+
+  vector<string> violation = opt.getViolations();
+
+  for (auto &v : violation)
+  {
+    auto pos = v.find(dir);
+
+    if (pos != string::npos)
+    {
+      v.replace(pos, dir.size(), "DIR");
+    }
+  }
+  if ((isCorrect != expected.empty()) or (violation != expected))
+  {
+    cerr << "unexpected violations:" << endl;
+    for (auto &v : violation)
+    {
+      cerr << "  " << v << endl;
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  char tmpl[] = "/tmp/optparser-path-XXXXXX";
+  string dir;
+  bool ok = true;
+
+  if (!mkdtemp(tmpl))
+  {
+    return EXIT_FAILURE;
+  }
+  dir = tmpl;
+  close(open((dir + "/file").c_str(), O_WRONLY | O_CREAT, 0644));
+  close(open((dir + "/ro").c_str(), O_WRONLY | O_CREAT, 0444));
+  mkdir((dir + "/sub").c_str(), 0755);
+  ok = check(dir,
+             {"--in", "file", "--dir", "sub", "--out", "new", "--log", "file", "file",
+              "sub"},
+             {}) and
+       ok;
+  ok = check(dir, {"--out", "file"}, {}) and ok;
+  // violations come in option order, then in argument order
+  ok = check(dir,
+             {"--in", "sub", "--dir", "file", "--out", "missing/new", "--log",
+              "missing", "missing", "file", "other"},
+             {"-i/--in=: path 'DIR/sub' is not a regular file",
+              "-d/--dir=: path 'DIR/file' is not a directory",
+              "-o/--out=: path 'DIR/missing/new' cannot be created",
+              "-l/--log=: path 'DIR/missing' does not exist",
+              "argument 1: path 'DIR/missing' does not exist",
+              "argument 3: path 'DIR/other' does not exist"}) and
+       ok;
+  ok = check(dir, {"--in", "missing"}, {"-i/--in=: path 'DIR/missing' does not exist"}) and
+       ok;
+  // enough paths to be checked by several threads, the order is kept
+  {
+    vector<string> arg, expected;
+
+    for (unsigned int i = 1; i <= 40; ++i)
+    {
+      arg.push_back((i % 3 == 0) ? "missing-" + strFrom(i) : "file");
+      if (i % 3 == 0)
+      {
+        expected.push_back("argument " + strFrom(i) + ": path 'DIR/missing-" +
+                           strFrom(i) + "' does not exist");
+      }
+    }
+    ok = check(dir, arg, expected) and ok;
+  }
+  // access() grants root write permission on read-only files
+  if (geteuid() != 0)
+  {
+    ok = check(dir, {"--log", "ro", "--out", "ro"},
+               {"-o/--out=: path 'DIR/ro' is not writable",
+                "-l/--log=: path 'DIR/ro' is not writable"}) and
+         ok;
+  }
+  remove((dir + "/file").c_str());
+  remove((dir + "/ro").c_str());
+  rmdir((dir + "/sub").c_str());
+  rmdir(dir.c_str());
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,100 @@
+#include "TestUtils.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace optp;
+
+static bool readAll(int fd, char *buf, size_t size)
+{
+  while (size > 0)
+  {
+    ssize_t n = read(fd, buf, size);
+
+    if (n <= 0)
+    {
+      return false;
+    }
+    buf += n;
+    size -= static_cast<size_t>(n);
+  }
+
+  return true;
+}
+
+// the parent parses and sends the serialised result through a pipe, the child
+// restores it into its own parser without parsing
+int main(void)
+{
+  const char *argv[] = {"serialize", "-a", "12", "-cz", "pos1", "", "pos 3"};
+  int fd[2];
+  pid_t pid;
+
+  if (pipe(fd) != 0)
+  {
+    return EXIT_FAILURE;
+  }
+  pid = fork();
+  if (pid == 0)
+  {
+    OptParser opt;
+    uint64_t size;
+    string blob;
+
+    close(fd[1]);
+    makeSchema(opt);
+    if (!readAll(fd[0], reinterpret_cast<char *>(&size), sizeof(size)))
+    {
+      _exit(EXIT_FAILURE);
+    }
+    blob.resize(size);
+    if (!readAll(fd[0], &blob[0], size))
+    {
+      _exit(EXIT_FAILURE);
+    }
+    opt.restore(FrozenResult::deserialize(blob));
+    if ((opt.optionValue<int>("a") != 12) or opt.gotOption("b") or
+        (opt.optionChoice("c") != 2) or (opt.getArgs().size() != 3) or
+        (opt.getArgs()[1] != "") or (opt.getArgs()[2] != "pos 3"))
+    {
+      _exit(EXIT_FAILURE);
+    }
+    blob[0] ^= 1;
+    try
+    {
+      FrozenResult::deserialize(blob);
+      _exit(EXIT_FAILURE);
+    }
+    catch (std::runtime_error &)
+    {
+    }
+    _exit(EXIT_SUCCESS);
+  }
+  else
+  {
+    OptParser opt;
+    string blob;
+    uint64_t size;
+    int status;
+
+    close(fd[0]);
+    makeSchema(opt);
+    if (!opt.parse(7, argv))
+    {
+      return EXIT_FAILURE;
+    }
+    blob = opt.freeze().serialize();
+    size = blob.size();
+    if ((write(fd[1], &size, sizeof(size)) != sizeof(size)) or
+        (write(fd[1], blob.data(), size) != static_cast<ssize_t>(size)))
+    {
+      return EXIT_FAILURE;
+    }
+    close(fd[1]);
+    waitpid(pid, &status, 0);
+
+    return (WIFEXITED(status) and (WEXITSTATUS(status) == EXIT_SUCCESS))
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,103 @@
+#include "TestUtils.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace optp;
+
+static FrozenResult makeResult(const unsigned int gen)
+{
+  OptParser opt;
+  string value = to_string(gen);
+  const char *argv[] = {"shared-memory", "-a", value.c_str(), "pos"};
+
+  makeSchema(opt);
+  opt.parse(4, argv);
+
+  return opt.freeze();
+}
+
+// worker: attaches repeatedly while the segment is republished, each attached
+// result must be complete and keep its value
+static int worker(const string &name)
+{
+  OptParser opt;
+  FrozenResult first;
+  string firstValue;
+
+  makeSchema(opt);
+  for (unsigned int i = 0; i < 500; ++i)
+  {
+    try
+    {
+      FrozenResult res = FrozenResult::attach(name);
+
+      opt.restore(res);
+      if ((opt.getArgs() != vector<string>{"pos"}) or opt.gotOption("b"))
+      {
+        cerr << "worker: unexpected result" << endl;
+
+        return EXIT_FAILURE;
+      }
+      if (first.empty())
+      {
+        first = res;
+        firstValue = first.optionValue(0u);
+      }
+    }
+    catch (exception &e)
+    {
+      cerr << "worker: " << e.what() << endl;
+
+      return EXIT_FAILURE;
+    }
+  }
+  if (first.optionValue(0u) != firstValue)
+  {
+    cerr << "worker: mapping of the first attach changed" << endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// the master publishes, starts a worker process and republishes new results
+// until it exits; attaching after unpublish must fail
+int main(int argc, char *argv[])
+{
+  string name = "/optparser-test-" + to_string(getpid());
+  unsigned int gen = 0;
+  pid_t pid;
+  int status;
+
+  if ((argc == 3) and (string(argv[1]) == "worker"))
+  {
+    return worker(argv[2]);
+  }
+  makeResult(gen).publish(name);
+  pid = fork();
+  if (pid == 0)
+  {
+    execl(argv[0], argv[0], "worker", name.c_str(), static_cast<char *>(nullptr));
+    _exit(EXIT_FAILURE);
+  }
+  while (waitpid(pid, &status, WNOHANG) == 0)
+  {
+    makeResult(++gen).publish(name);
+  }
+  FrozenResult::unpublish(name);
+  try
+  {
+    FrozenResult::attach(name);
+    cerr << "attach succeeded after unpublish" << endl;
+
+    return EXIT_FAILURE;
+  }
+  catch (runtime_error &)
+  {
+  }
+
+  return (WIFEXITED(status) and (WEXITSTATUS(status) == EXIT_SUCCESS)) ? EXIT_SUCCESS
+                                                                       : EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+#include "TestUtils.hpp"
+#include <dirent.h>
+
+using namespace std;
+using namespace optp;
+
+static vector<string> listDir(const string &dir)
+{
+  vector<string> res;
+  DIR *d = opendir(dir.c_str());
+
+  while (struct dirent *e = d ? readdir(d) : nullptr)
+  {
+    if (e->d_name[0] != '.')
+    {
+      res.push_back(e->d_name);
+    }
+  }
+  if (d)
+  {
+    closedir(d);
+  }
+  sort(res.begin(), res.end());
+
+  return res;
+}
+
+static bool readFails(const string &path)
+{
+  try
+  {
+    FrozenResult::readSnapshot(path);
+  }
+  catch (runtime_error &)
+  {
+    return true;
+  }
+
+  return false;
+}
+
+// round trip through a snapshot file, no temporary file left behind, and
+// empty, corrupted or truncated snapshots rejected
+static bool test(const string &dir)
+{
+  OptParser opt, restored;
+  const char *argv[] = {"snapshot", "-a", "12", "-cz", "pos1", "", "pos 3"};
+  string path = dir + "/snap.bin", blob;
+
+  makeSchema(opt);
+  makeSchema(restored);
+  if (!opt.parse(7, argv))
+  {
+    return fail("parse failed");
+  }
+  try
+  {
+    FrozenResult().writeSnapshot(path);
+
+    return fail("empty result written");
+  }
+  catch (runtime_error &)
+  {
+  }
+  if (!listDir(dir).empty())
+  {
+    return fail("empty result left a file behind");
+  }
+  opt.writeSnapshot(path);
+  opt.writeSnapshot(path);
+  if (listDir(dir) != vector<string>{"snap.bin"})
+  {
+    return fail("temporary file left behind");
+  }
+  restored.readSnapshot(path);
+  if ((restored.optionValue<int>("a") != 12) or restored.gotOption("b") or
+      (restored.optionChoice("c") != 2) or (restored.getArgs() != opt.getArgs()))
+  {
+    return fail("snapshot round trip changed the result");
+  }
+  {
+    ifstream file(path, ios::binary);
+
+    blob.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  }
+  // flip a bit in the last positional argument
+  blob[blob.size() - 2] ^= 1;
+  ofstream(dir + "/corrupt.bin", ios::binary) << blob;
+  ofstream(dir + "/truncated.bin", ios::binary) << blob.substr(0, blob.size() / 2);
+  if (!readFails(dir + "/corrupt.bin") or !readFails(dir + "/truncated.bin") or
+      !readFails(dir + "/missing.bin"))
+  {
+    return fail("bad snapshot accepted");
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  char tmpl[] = "/tmp/optparser-snapshot-XXXXXX";
+  string dir;
+  bool ok;
+
+  if (!mkdtemp(tmpl))
+  {
+    return EXIT_FAILURE;
+  }
+  dir = tmpl;
+  ok = test(dir);
+  for (auto &f : listDir(dir))
+  {
+    remove((dir + "/" + f).c_str());
+  }
+  rmdir(dir.c_str());
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
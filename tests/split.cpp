@@ -0,0 +1,70 @@
+#include <OptParser.hpp>
+
+using namespace std;
+using namespace optp;
+
+struct Case
+{
+  string cmdline;
+  vector<string> word;
+  bool error;
+};
+
+// POSIX shell splitting of a command line given as one string
+int main(void)
+{
+  const vector<Case> table = {
+      {"a  b\tc\nd", {"a", "b", "c", "d"}, false},
+      {"'x y'", {"x y"}, false},
+      {"'a\\b' 'it'\\''s'", {"a\\b", "it's"}, false},
+      {"\"a\\\"b\"", {"a\"b"}, false},
+      {"\"\\$x \\` \\\\ \\n\"", {"$x ` \\ \\n"}, false},
+      {"c\\ d", {"c d"}, false},
+      {"a#b #c d\ne", {"a#b", "e"}, false},
+      {"# only a comment", {}, false},
+      {"a \\\nb", {"a", "b"}, false},
+      {"a\\\nb", {"ab"}, false},
+      {"\"a\\\nb\"", {"ab"}, false},
+      {"'' \"\" x''", {"", "", "x"}, false},
+      {"pre'mid'\"post\"", {"premidpost"}, false},
+      {"", {}, false},
+      {"'unterminated", {}, true},
+      {"\"unterminated 'x'", {}, true},
+      {"a \\", {}, true},
+      {"a\\", {}, true}};
+  bool ok = true;
+
+  for (auto &t : table)
+  {
+    vector<string> word;
+    bool error = false;
+
+    try
+    {
+      Argv argv = OptParser::splitCommandLine(t.cmdline);
+
+      for (int i = 0; i < argv.argc(); ++i)
+      {
+        word.push_back(argv.argv()[i]);
+      }
+      // argv is null-terminated like the one given to main
+      error = (argv.argv()[argv.argc()] != nullptr);
+    }
+    catch (invalid_argument &)
+    {
+      error = true;
+    }
+    if ((error != t.error) or (!error and (word != t.word)))
+    {
+      cerr << "unexpected split of [" << t.cmdline << "]:";
+      for (auto &w : word)
+      {
+        cerr << " [" << w << "]";
+      }
+      cerr << (error ? " (error)" : "") << endl;
+      ok = false;
+    }
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
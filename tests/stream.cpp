@@ -0,0 +1,98 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+// events of a NUL-delimited stream fed in chunks of the given size
+static string streamEvents(OptParser &opt, const string &stream,
+                           const size_t chunk, bool &isCorrect)
+{
+  auto reader = opt.eventStream();
+  vector<string> piece;
+  string res;
+  ParseEvent ev;
+
+  // the chunks must outlive the reader's use of them
+  for (size_t pos = 0; pos < stream.size(); pos += chunk)
+  {
+    piece.push_back(stream.substr(pos, chunk));
+  }
+  for (auto &p : piece)
+  {
+    reader.feed(p.data(), p.size());
+    while (reader.next(ev))
+    {
+      res += eventString(ev);
+    }
+  }
+  reader.close();
+  while (reader.next(ev))
+  {
+    res += eventString(ev);
+  }
+  isCorrect = reader.isCorrect() and reader.done();
+
+  return res;
+}
+
+// the same command line read from argv and from a stream cut in chunks of 1
+// and 3 bytes and in one chunk: tokens split across chunks, values pending
+// across a chunk boundary and an unterminated last argument give the same
+// events
+int main(void)
+{
+  OptParser opt;
+  const vector<vector<string>> cmdline = {
+      {"-a", "--alpha=long value", "pos", "-b", "--alpha", "v w", "", "-ay", "last"},
+      {"--alpha", "pending", "-b", "-a"},
+      {"--unknown", "-ab", "positional argument", "--alpha"}};
+  bool ok = true;
+
+  opt.addOption("a", "alpha", OptParser::OptType::value, true);
+  opt.addOption("b", "beta", OptParser::OptType::trigger, true);
+  for (auto &tok : cmdline)
+  {
+    vector<const char *> argv = {"stream"};
+    string stream, ref;
+    ostringstream warning;
+    streambuf *cerrBuf = cerr.rdbuf(warning.rdbuf());
+    bool refCorrect;
+
+    for (auto &t : tok)
+    {
+      argv.push_back(t.c_str());
+      stream += t + '\0';
+    }
+    {
+      auto reader = opt.events(static_cast<int>(argv.size()), argv.data());
+
+      for (auto &ev : reader)
+      {
+        ref += eventString(ev);
+      }
+      refCorrect = reader.isCorrect();
+    }
+    for (bool terminated : {true, false})
+    {
+      string s = terminated ? stream : stream.substr(0, stream.size() - 1);
+
+      for (size_t chunk : {size_t(1), size_t(3), s.size()})
+      {
+        bool isCorrect;
+        string got = streamEvents(opt, s, chunk, isCorrect);
+
+        if ((got != ref) or (isCorrect != refCorrect))
+        {
+          cerr.rdbuf(cerrBuf);
+          cerr << "chunk " << chunk << (terminated ? "" : " unterminated") << endl;
+          cerr << "expected " << ref << endl << "got      " << got << endl;
+          cerrBuf = cerr.rdbuf(warning.rdbuf());
+          ok = false;
+        }
+      }
+    }
+    cerr.rdbuf(cerrBuf);
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+using Kind = ParseTrace::Kind;
+using Action = ParseTrace::Action;
+
+// parse with the warnings discarded
+static void parse(OptParser &opt, const int argc, const char *argv[])
+{
+  string warning;
+
+  parseCapture(opt, argc, argv, warning);
+}
+
+static bool sameEntries(const ParseTrace &trace, const vector<ParseTrace::Entry> &expected)
+{
+  if (trace.size() != expected.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    const ParseTrace::Entry &e = trace[i];
+
+    if ((e.token != expected[i].token) or (e.opt != expected[i].opt) or
+        (e.kind != expected[i].kind) or (e.action != expected[i].action))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  OptParser opt;
+  ParseTrace trace;
+  bool ok = true;
+
+  opt.addOption("a", "long-a", OptParser::OptType::value, true, "option a");
+  opt.addOption("b", "long-b", OptParser::OptType::trigger, true, "option b");
+  opt.addOption("", "long-bb", OptParser::OptType::trigger, true, "option bb");
+  opt.allowAbbreviation();
+  opt.setTrace(&trace);
+
+  // missing values, unknown and ambiguous options
+  {
+    const char *argv[] = {"trace", "-a", "--long-b", "--nope", "--long",
+                          "-q",    "pos", "-a1",     "-a"};
+
+    parse(opt, 9, argv);
+    ok &= sameEntries(trace, {{0, 0, Kind::shortOption, Action::expectValue},
+                              {1, 0, Kind::longOption, Action::missingValue},
+                              {1, 1, Kind::longOption, Action::option},
+                              {2, -1, Kind::longOption, Action::unknown},
+                              {3, -1, Kind::longOption, Action::ambiguous},
+                              {4, -1, Kind::shortOption, Action::unknown},
+                              {5, -1, Kind::argument, Action::positional},
+                              {6, 0, Kind::shortOption, Action::option},
+                              {7, 0, Kind::shortOption, Action::expectValue},
+                              {8, 0, Kind::argument, Action::missingValue}}) or
+          fail("unexpected entries for a command line with errors");
+    ok &= (trace.total() == 10) or fail("unexpected total");
+
+    ostringstream out;
+
+    trace.dump(out);
+    ok &= (out.str().compare(0, 60, "0 short-option expect-value 0\n"
+                                    "1 long-option missing-value 0\n") == 0) or
+          fail("unexpected dump '" + out.str() + "'");
+  }
+
+  // the trace is cleared by the next parse
+  {
+    const char *argv[] = {"trace", "-a", "x", "y"};
+
+    parse(opt, 4, argv);
+    ok &= sameEntries(trace, {{0, 0, Kind::shortOption, Action::expectValue},
+                              {1, 0, Kind::argument, Action::value},
+                              {2, -1, Kind::argument, Action::positional}}) or
+          fail("trace not cleared between parses");
+  }
+
+  // only the last capacity decisions are kept, oldest first
+  {
+    const unsigned int n = ParseTrace::capacity + 500;
+    vector<string> token;
+    vector<const char *> argv = {"trace"};
+
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      token.push_back((i % 2 == 0) ? "-b" : "pos");
+    }
+    for (auto &t : token)
+    {
+      argv.push_back(t.c_str());
+    }
+    parse(opt, static_cast<int>(argv.size()), argv.data());
+    ok &= ((trace.total() == n) and (trace.size() == ParseTrace::capacity)) or
+          fail("unexpected size after wrap-around");
+    for (unsigned int i = 0; i < trace.size(); ++i)
+    {
+      const ParseTrace::Entry &e = trace[i];
+      const uint32_t t = n - ParseTrace::capacity + i;
+      const bool isOpt = (t % 2 == 0);
+
+      if ((e.token != t) or (e.opt != (isOpt ? 1 : -1)) or
+          (e.action != (isOpt ? Action::option : Action::positional)))
+      {
+        ok = fail("unexpected entry " + strFrom(i) + " after wrap-around");
+        break;
+      }
+    }
+  }
+  opt.setTrace(nullptr);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
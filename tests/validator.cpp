@@ -0,0 +1,60 @@
+#include <OptParser.hpp>
+
+using namespace std;
+using namespace optp;
+
+// runs the parse and compares the violations, reported all at once
+static bool check(const vector<const char *> &arg, const vector<string> &expected)
+{
+  OptParser opt;
+  vector<const char *> argv = {"validator"};
+  ostringstream warning;
+  streambuf *cerrBuf = cerr.rdbuf(warning.rdbuf());
+  bool isCorrect;
+
+  opt.addOption("n", "num", OptParser::OptType::value, true, "number", "0");
+  opt.addOption("f", "file", OptParser::OptType::value, true, "file name");
+  opt.addOption("", "ratio", OptParser::OptType::value, true, "ratio");
+  opt.addValidator<int>("num", inRange(-5, 5));
+  opt.addValidator<string>("file", matchesGlob("*.txt"));
+  opt.addValidator<double>("ratio", inRange(0., 1.));
+  argv.insert(argv.end(), arg.begin(), arg.end());
+  isCorrect = opt.parse(static_cast<int>(argv.size()), argv.data());
+  cerr.rdbuf(cerrBuf);
+  if ((isCorrect != expected.empty()) or (opt.getViolations() != expected))
+  {
+    cerr << "unexpected result for";
+    for (auto a : arg)
+    {
+      cerr << " '" << a << "'";
+    }
+    cerr << ":" << endl;
+    for (auto &v : opt.getViolations())
+    {
+      cerr << "  " << v << endl;
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+int main(void)
+{
+  bool ok = true;
+
+  ok = check({"--num=3", "-f", "a.txt", "--ratio", "0.5"}, {}) and ok;
+  ok = check({"--num=7"}, {"-n/--num=: value '7' must be in [-5, 5]"}) and ok;
+  ok = check({"--file=a.csv"}, {"-f/--file=: value 'a.csv' must match '*.txt'"}) and ok;
+  ok = check({"--num=abc"}, {"-n/--num=: value 'abc' is not a valid integer"}) and ok;
+  ok = check({"--num=3xyz"}, {"-n/--num=: value '3xyz' is not a valid integer"}) and ok;
+  ok = check({"--ratio=1e"}, {"--ratio=: value '1e' is not a valid number"}) and ok;
+  ok = check({"--ratio=2", "-n", "-9", "--file", "b"},
+             {"-n/--num=: value '-9' must be in [-5, 5]",
+              "-f/--file=: value 'b' must match '*.txt'",
+              "--ratio=: value '2' must be in [0, 1]"}) and
+       ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
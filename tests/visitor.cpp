@@ -0,0 +1,95 @@
+#include "TestUtils.hpp"
+
+using namespace std;
+using namespace optp;
+
+// shared schema with a validator and a constraint
+static void makeVisitorSchema(OptParser &opt)
+{
+  makeSchema(opt);
+  opt.addValidator<int>("a", inRange(0, 10));
+  opt.addConflict({"b", "c"});
+}
+
+// visitor parse of args, returns the recorded events and warnings
+static bool visit(OptParser &opt, vector<const char *> args, string &log,
+                  string &warning)
+{
+  RecordVisitor visitor;
+  CerrCapture capture;
+  bool isCorrect;
+
+  args.insert(args.begin(), "visitor");
+  isCorrect = opt.parse(static_cast<int>(args.size()), args.data(), visitor);
+  log = visitor.log;
+  warning = capture.str();
+
+  return isCorrect;
+}
+
+// the visitor receives the events in command line order while choices,
+// validators and constraints are still checked, and the parse result is left
+// untouched
+int main(void)
+{
+  bool ok = true;
+  string log, warning;
+
+  // valid command line
+  {
+    OptParser opt;
+
+    makeVisitorSchema(opt);
+    ok &= visit(opt, {"-a", "3", "-cy", "pos", "--long-a=4"}, log, warning) or
+          fail("valid command line rejected\n" + warning);
+    ok &= (log == "O0:3;O2:y;P:pos;O0:4;") or fail("unexpected events " + log);
+    ok &= warning.empty() or fail("unexpected warnings\n" + warning);
+  }
+
+  // unknown option, missing value, invalid choice, validator and constraint
+  {
+    OptParser opt;
+
+    makeVisitorSchema(opt);
+    ok &= !visit(opt, {"-a", "30", "pos1", "--nope", "-b", "-cw", "pos2", "-a"}, log,
+                 warning) or
+          fail("invalid command line accepted");
+    ok &= (log == "O0:30;P:pos1;O1:<none>;O2:w;P:pos2;O0:<none>;") or
+          fail("unexpected events " + log);
+    ok &= (warning == "warning: unknown option '--nope'\n"
+                      "warning: invalid value 'w' for option -c, expected one of x, "
+                      "y, z\n"
+                      "warning: expected value for option -a/--long-a=\n"
+                      "warning: -a/--long-a=: value '30' must be in [0, 10]\n"
+                      "warning: options -b/--long-b, -c are mutually exclusive\n") or
+          fail("unexpected warnings\n" + warning);
+  }
+
+  // mandatory option never given
+  {
+    OptParser opt;
+
+    makeVisitorSchema(opt);
+    ok &= !visit(opt, {"pos"}, log, warning) or fail("missing mandatory option accepted");
+    ok &= (log == "P:pos;") or fail("unexpected events " + log);
+    ok &= (warning == "warning: mandatory option -a/--long-a= is missing\n") or
+          fail("unexpected warnings\n" + warning);
+  }
+
+  // the result of the previous parse stays in place
+  {
+    OptParser opt;
+    const char *argv[] = {"visitor", "-a", "1", "-b", "first"};
+
+    makeVisitorSchema(opt);
+    ok &= parseCapture(opt, 5, argv, warning) or fail("first parse failed\n" + warning);
+    ok &= visit(opt, {"-a", "5", "-cz", "second", "third"}, log, warning) or
+          fail("visitor parse failed\n" + warning);
+    ok &= ((opt.optionValue<int>("a") == 1) and opt.gotOption("b") and
+           !opt.gotOption("c") and (opt.optionValue("c") == "x") and
+           (opt.getArgs() == vector<string>{"first"})) or
+          fail("visitor parse changed the stored result");
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,9 @@
+#include <Workload.hpp>
+
+// second translation unit including the headers, so that the test fails to link
+// if they define functions that are not inline
+std::vector<std::string> workloadArgs(const uint64_t seed, const unsigned int nOpt,
+                                      const std::size_t nToken)
+{
+  return optp::Workload(seed, nOpt).makeArgs(nToken);
+}
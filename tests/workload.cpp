@@ -0,0 +1,55 @@
+#include <Workload.hpp>
+
+using namespace std;
+using namespace optp;
+
+// defined in workload-unit.cpp
+vector<string> workloadArgs(const uint64_t seed, const unsigned int nOpt,
+                            const size_t nToken);
+
+// the generator is deterministic and its command lines parse without warning
+// against its schemas
+int main(void)
+{
+  for (unsigned int nOpt : {1u, 10u, 100u, 1000u})
+  {
+    Workload w1(nOpt, nOpt), w2(nOpt, nOpt), w3(nOpt + 1, nOpt);
+    vector<string> args = w1.makeArgs(10000);
+    auto argv = Workload::argv(args);
+    OptParser opt;
+    ostringstream warning;
+    streambuf *cerrBuf;
+    bool isCorrect;
+
+    if (w2.makeArgs(10000) != args)
+    {
+      cerr << "seed " << nOpt << ": different command lines" << endl;
+
+      return EXIT_FAILURE;
+    }
+    if (workloadArgs(nOpt, nOpt, 10000) != args)
+    {
+      cerr << "seed " << nOpt << ": different command line in another unit" << endl;
+
+      return EXIT_FAILURE;
+    }
+    if (w3.makeArgs(10000) == args)
+    {
+      cerr << "seeds " << nOpt << " and " << nOpt + 1 << ": same command line" << endl;
+
+      return EXIT_FAILURE;
+    }
+    w1.makeSchema(opt);
+    cerrBuf = cerr.rdbuf(warning.rdbuf());
+    isCorrect = opt.parse(static_cast<int>(argv.size()), argv.data());
+    cerr.rdbuf(cerrBuf);
+    if (!isCorrect or !warning.str().empty())
+    {
+      cerr << "seed " << nOpt << ": parse failed" << endl << warning.str();
+
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,303 @@
+/*
+ * Workload.hpp, part of OptParser
+ *
+ * Copyright (C) 2022-2023 Antonin Portelli
+ *
+ * OptParser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OptParser is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OptParser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Workload_hpp_
+#define Workload_hpp_
+
+#include <OptParser.hpp>
+#include <random>
+#include <set>
+
+namespace OPT_PARSER_NS
+{
+// Synthetic schemas and command lines for scaling studies. The output only
+// depends on the seed and on the sequence of calls: the random numbers are
+// drawn from std::mt19937_64 without the standard distributions, whose
+// results differ between library implementations.
+class Workload
+{
+public:
+  struct Option
+  {
+    std::string shortName, longName;
+    OptParser::OptType type;
+    bool optional;
+    std::vector<std::string> choice;
+  };
+  // proportions of the generated command line
+  struct Mix
+  {
+    // options among tokens (an option and its separate value count as two)
+    double option{0.5};
+    // values given as --name=value rather than --name value
+    double inlineValue{0.5};
+    // options given by their short name when they have one
+    double shortForm{0.2};
+  };
+
+public:
+  // constructor
+  explicit Workload(const uint64_t seed, const unsigned int nOpt);
+  // access
+  const std::vector<Option> &option(void) const;
+  void makeSchema(OptParser &parser) const;
+  // command line of at least nToken tokens (without program name) valid for
+  // the schema, mandatory options come first
+  std::vector<std::string> makeArgs(const std::size_t nToken, const Mix &mix);
+  std::vector<std::string> makeArgs(const std::size_t nToken);
+  // argv-like view on args, with a program name, valid while args lives
+  static std::vector<const char *> argv(const std::vector<std::string> &args);
+
+private:
+  uint64_t uniform(const uint64_t n);
+  bool bernoulli(const double p);
+  const std::string &pick(const std::vector<std::string> &v);
+  std::string makeName(void);
+  std::string makeValue(const Option &opt);
+  std::string makeArg(void);
+
+private:
+  std::mt19937_64 rng_;
+  std::vector<Option> option_;
+};
+
+// implementation //////////////////////////////////////////////////////////////
+// words and prefixes found in common command-line tools
+inline const std::vector<std::string> &workloadWord(void)
+{
+  static const std::vector<std::string> word = {
+      "input",   "output", "verbose", "quiet",  "thread",  "size",    "file",
+      "dir",     "log",    "level",   "cache",  "timeout", "retry",   "buffer",
+      "format",  "config", "debug",   "run",    "color",   "depth",   "limit",
+      "path",    "mode",   "batch",   "seed",   "port",    "host",    "user",
+      "count",   "prefix", "suffix",  "filter", "sort",    "key",     "index",
+      "compress", "ignore", "include", "exclude", "jobs",   "version", "help",
+      "force",   "recursive", "list",  "name",   "type",    "width",   "height"};
+
+  return word;
+}
+
+inline const std::vector<std::string> &workloadPrefix(void)
+{
+  static const std::vector<std::string> prefix = {
+      "no-", "enable-", "disable-", "with-", "without-", "max-", "min-", "use-"};
+
+  return prefix;
+}
+
+// constructor /////////////////////////////////////////////////////////////////
+// Long names are one to three words, a third of them behind a shared prefix,
+// which gives the long common prefixes that abbreviation lookups have to
+// resolve. The first options get a single-letter short name.
+inline Workload::Workload(const uint64_t seed, const unsigned int nOpt) : rng_(seed)
+{
+  std::set<std::string> used;
+  std::string letter;
+
+  for (char c = 'a'; c <= 'z'; ++c)
+  {
+    letter += c;
+    letter += static_cast<char>(c - 'a' + 'A');
+  }
+  for (unsigned int i = 0; i < nOpt; ++i)
+  {
+    Option opt;
+    uint64_t kind = uniform(10);
+
+    opt.longName = makeName();
+    while (!used.insert(opt.longName).second)
+    {
+      opt.longName += "-" + makeName();
+    }
+    if (i < letter.size())
+    {
+      opt.shortName = letter.substr(i, 1);
+    }
+    opt.type = (kind < 4) ? OptParser::OptType::trigger : OptParser::OptType::value;
+    opt.optional = (opt.type == OptParser::OptType::trigger) or bernoulli(0.95);
+    if (kind == 9)
+    {
+      uint64_t nChoice = 2 + uniform(5);
+
+      for (uint64_t c = 0; c < nChoice; ++c)
+      {
+        opt.choice.push_back(pick(workloadWord()));
+      }
+      std::sort(opt.choice.begin(), opt.choice.end());
+      opt.choice.erase(std::unique(opt.choice.begin(), opt.choice.end()),
+                       opt.choice.end());
+    }
+    option_.push_back(opt);
+  }
+}
+
+// access //////////////////////////////////////////////////////////////////////
+inline const std::vector<Workload::Option> &Workload::option(void) const
+{
+  return option_;
+}
+
+inline void Workload::makeSchema(OptParser &parser) const
+{
+  for (auto &opt : option_)
+  {
+    std::string help = "synthetic option " + opt.longName;
+
+    if (opt.choice.empty())
+    {
+      parser.addOption(opt.shortName, opt.longName, opt.type, opt.optional, help);
+    }
+    else
+    {
+      parser.addChoice(opt.shortName, opt.longName, opt.choice, opt.optional, help);
+    }
+  }
+}
+
+inline std::vector<std::string> Workload::makeArgs(const std::size_t nToken,
+                                                   const Mix &mix)
+{
+  std::vector<std::string> args;
+  std::vector<unsigned int> mandatory;
+
+  for (unsigned int i = 0; i < option_.size(); ++i)
+  {
+    if (!option_[i].optional)
+    {
+      mandatory.push_back(i);
+    }
+  }
+  args.reserve(nToken + 1);
+  while ((args.size() < nToken) or !mandatory.empty())
+  {
+    if (option_.empty() or (mandatory.empty() and !bernoulli(mix.option)))
+    {
+      args.push_back(makeArg());
+      continue;
+    }
+
+    unsigned int i;
+    const Option *opt;
+    std::string key;
+
+    if (!mandatory.empty())
+    {
+      i = mandatory.back();
+      mandatory.pop_back();
+    }
+    else
+    {
+      i = static_cast<unsigned int>(uniform(option_.size()));
+    }
+    opt = &option_[i];
+    if (!opt->shortName.empty() and bernoulli(mix.shortForm))
+    {
+      key = "-" + opt->shortName;
+    }
+    else
+    {
+      key = "--" + opt->longName;
+    }
+    if (opt->type == OptParser::OptType::trigger)
+    {
+      args.push_back(key);
+    }
+    else if ((key[1] == '-') and bernoulli(mix.inlineValue))
+    {
+      args.push_back(key + "=" + makeValue(*opt));
+    }
+    else
+    {
+      args.push_back(key);
+      args.push_back(makeValue(*opt));
+    }
+  }
+
+  return args;
+}
+
+inline std::vector<std::string> Workload::makeArgs(const std::size_t nToken)
+{
+  return makeArgs(nToken, Mix());
+}
+
+inline std::vector<const char *> Workload::argv(const std::vector<std::string> &args)
+{
+  std::vector<const char *> v = {"workload"};
+
+  for (auto &a : args)
+  {
+    v.push_back(a.c_str());
+  }
+
+  return v;
+}
+
+// random generation ///////////////////////////////////////////////////////////
+inline uint64_t Workload::uniform(const uint64_t n) { return rng_() % n; }
+
+inline bool Workload::bernoulli(const double p)
+{
+  return static_cast<double>(rng_() >> 11) < p * 9007199254740992.;
+}
+
+inline const std::string &Workload::pick(const std::vector<std::string> &v)
+{
+  return v[uniform(v.size())];
+}
+
+inline std::string Workload::makeName(void)
+{
+  std::string name = bernoulli(1. / 3.) ? pick(workloadPrefix()) : "";
+  uint64_t nWord = 1 + uniform(3);
+
+  for (uint64_t w = 0; w < nWord; ++w)
+  {
+    name += ((w > 0) ? "-" : "") + pick(workloadWord());
+  }
+
+  return name;
+}
+
+// numbers, words and paths, never starting with a dash
+inline std::string Workload::makeValue(const Option &opt)
+{
+  if (!opt.choice.empty())
+  {
+    return pick(opt.choice);
+  }
+  switch (uniform(3))
+  {
+  case 0:
+    return std::to_string(uniform(100000));
+  case 1:
+    return pick(workloadWord());
+  default:
+    return makeArg();
+  }
+}
+
+inline std::string Workload::makeArg(void)
+{
+  return pick(workloadWord()) + "/" + pick(workloadWord()) + "-" +
+         std::to_string(uniform(1000)) + ".dat";
+}
+} // namespace OPT_PARSER_NS
+
+#endif // Workload_hpp_
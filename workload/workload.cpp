@@ -0,0 +1,70 @@
+#include "Workload.hpp"
+#include <iostream>
+
+using namespace std;
+using namespace optp;
+
+// Prints the schema (one option per line: short name, long name, type,
+// optional, choices) or the command line (one argument per line, or
+// NUL-separated for StreamReader and xargs -0).
+int main(int argc, char *argv[])
+{
+  OptParser opt;
+  Workload::Mix mix;
+
+  opt.addOption("s", "seed", OptParser::OptType::value, true, "random seed", "0");
+  opt.addOption("n", "options", OptParser::OptType::value, true, "number of options",
+                "100");
+  opt.addOption("t", "tokens", OptParser::OptType::value, true,
+                "number of command line tokens", "1000");
+  opt.addOption("", "option-fraction", OptParser::OptType::value, true,
+                "fraction of option tokens", strFrom(mix.option));
+  opt.addOption("", "inline-fraction", OptParser::OptType::value, true,
+                "fraction of values given as --name=value", strFrom(mix.inlineValue));
+  opt.addOption("", "short-fraction", OptParser::OptType::value, true,
+                "fraction of options given by short name", strFrom(mix.shortForm));
+  opt.addOption("", "schema", OptParser::OptType::trigger, true,
+                "print the schema instead of the command line");
+  opt.addOption("z", "null", OptParser::OptType::trigger, true,
+                "separate arguments with NUL characters");
+  opt.addOption("h", "help", OptParser::OptType::trigger, true, "show this help message");
+  if (!opt.parse(argc, const_cast<const char **>(argv)) or opt.gotOption("help"))
+  {
+    cerr << "usage: " << argv[0] << " [options]" << endl;
+    cerr << opt << endl;
+
+    return EXIT_FAILURE;
+  }
+  mix.option = opt.optionValue<double>("option-fraction");
+  mix.inlineValue = opt.optionValue<double>("inline-fraction");
+  mix.shortForm = opt.optionValue<double>("short-fraction");
+
+  Workload workload(opt.optionValue<uint64_t>("seed"),
+                    opt.optionValue<unsigned int>("options"));
+
+  if (opt.gotOption("schema"))
+  {
+    for (auto &o : workload.option())
+    {
+      cout << (o.shortName.empty() ? "-" : o.shortName) << '\t' << o.longName << '\t'
+           << ((o.type == OptParser::OptType::value) ? "value" : "trigger") << '\t'
+           << (o.optional ? "optional" : "mandatory") << '\t';
+      for (auto &c : o.choice)
+      {
+        cout << c << ((&c == &o.choice.back()) ? "" : ",");
+      }
+      cout << '\n';
+    }
+  }
+  else
+  {
+    char sep = opt.gotOption("null") ? '\0' : '\n';
+
+    for (auto &a : workload.makeArgs(opt.optionValue<size_t>("tokens"), mix))
+    {
+      cout << a << sep;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}